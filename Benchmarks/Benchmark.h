@@ -0,0 +1,168 @@
+/*
+  ==============================================================================
+
+    Benchmark.h
+    Timed renders of the synth's parts, run by the GGranulaBenchmarks app.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "PluginProcessor.h"
+#include <limits>
+
+//==============================================================================
+/** One measurement, registered by declaring it static.
+
+    Times are the best of a few rounds after a warm-up one, so caches are
+    warm and scheduling hiccups don't count. Only Release builds give
+    numbers worth comparing.
+*/
+class Benchmark
+{
+public:
+    //==============================================================================
+    explicit Benchmark (const juce::String& name): _name(name)
+    {
+        getAll().add(this);
+    }
+    virtual ~Benchmark ()
+    {
+        getAll().removeFirstMatchingValue(this);
+    }
+    
+    //==============================================================================
+    virtual void run () = 0;
+    const juce::String& getName () const noexcept
+    {
+        return _name;
+    }
+    static juce::Array<Benchmark*>& getAll ()
+    {
+        static juce::Array<Benchmark*> benchmarks;
+        return benchmarks;
+    }
+    // Seconds one call of work takes, num_calls calls per round; public for
+    // the helpers several benchmarks share.
+    template <typename Work>
+    static double timePerCall (int num_calls, Work&& work)
+    {
+        auto best = std::numeric_limits<double>::max();
+        for (int round = 0; round <= NUM_ROUNDS; ++round)
+        {
+            const auto start_ticks = juce::Time::getHighResolutionTicks();
+            for (int call = 0; call < num_calls; ++call)
+            {
+                work();
+            }
+            const auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start_ticks);
+            if (round > 0) // the first one warms up
+            {
+                best = juce::jmin(best, seconds / num_calls);
+            }
+        }
+        return best;
+    }
+    
+protected:
+    //==============================================================================
+    static juce::String percent (double share)
+    {
+        return juce::String(share * 100.0, 2) + "%";
+    }
+    void report (const juce::String& result) const
+    {
+        juce::Logger::writeToLog(_name + ": " + result);
+    }
+    
+private:
+    //==============================================================================
+    static constexpr int NUM_ROUNDS = 5;
+    
+    const juce::String _name;
+    
+    JUCE_DECLARE_NON_COPYABLE (Benchmark)
+};
+
+//==============================================================================
+/** A Synthesizer on a state of its own, rendering stereo blocks at 48 kHz
+    the way processBlock() does, without parameters or the processor.
+*/
+class BenchmarkSynth
+{
+public:
+    //==============================================================================
+    static constexpr double SAMPLE_RATE = 48000.0;
+    static constexpr int    BLOCK_SIZE  = 128;
+    static constexpr int    NUM_CHANNELS = 2;
+    
+    //==============================================================================
+    explicit BenchmarkSynth (SynthesizerState::SynthesizerInitialState initial_state):
+        _state(std::make_shared<SynthesizerState>(initial_state)),
+        _synthesizer(_state),
+        _buffer(NUM_CHANNELS, BLOCK_SIZE)
+    {
+        _synthesizer.setOversamplingOrder(initial_state.realtime_oversampling);
+        _synthesizer.prepare({
+            .juce_spec = {
+                .sampleRate       = SAMPLE_RATE,
+                .maximumBlockSize = static_cast<juce::uint32>(BLOCK_SIZE),
+                .numChannels      = static_cast<juce::uint32>(NUM_CHANNELS)
+            }
+        });
+    }
+    
+    //==============================================================================
+    SynthesizerState& getState () noexcept
+    {
+        return *_state;
+    }
+    Synthesizer& getSynthesizer () noexcept
+    {
+        return _synthesizer;
+    }
+    // Notes go up from the lowest and wrap around; a note played again
+    // releases its previous voice, which keeps sounding for the release time
+    // (none at all while still at the start of a slow attack).
+    void playNotes (int num_notes)
+    {
+        for (int index = 0; index < num_notes; ++index)
+        {
+            _synthesizer.noteOn(juce::MidiMessage::noteOn(1, LOWEST_NOTE + index % NUM_NOTES, 0.8f));
+        }
+    }
+    void renderBlock () noexcept
+    {
+        _buffer.clear();
+        juce::dsp::AudioBlock<BufferData> block(_buffer);
+        juce::dsp::ProcessContextReplacing<BufferData> context(block);
+        _synthesizer.renderNextBlock({ .juce_context = context }, _no_events);
+    }
+    // Every one of num_voices notes keeps a voice sounding, see playNotes().
+    static SynthesizerState::SynthesizerInitialState heldVoices (unsigned int num_voices)
+    {
+        SynthesizerState::SynthesizerInitialState initial_state;
+        initial_state.num_of_voices = num_voices;
+        initial_state.amp_attack    = 0.0f;  // a voice released in its attack would end at once
+        initial_state.amp_release   = 60.0f; // notes played twice keep their released voice
+        return initial_state;
+    }
+    // Share of one core rendering takes in realtime.
+    static double getLoad (double seconds_per_block) noexcept
+    {
+        return seconds_per_block * SAMPLE_RATE / BLOCK_SIZE;
+    }
+    
+private:
+    //==============================================================================
+    static constexpr int LOWEST_NOTE = 24;
+    static constexpr int NUM_NOTES   = 84;
+    
+    std::shared_ptr<SynthesizerState> _state;
+    Synthesizer                       _synthesizer;
+    juce::AudioBuffer<float>          _buffer;
+    const juce::MidiBuffer            _no_events;
+    
+    JUCE_DECLARE_NON_COPYABLE (BenchmarkSynth)
+};
@@ -0,0 +1,26 @@
+/*
+  ==============================================================================
+
+    BenchmarkMain.cpp
+    Runs every benchmark, or those whose name contains the first argument.
+
+  ==============================================================================
+*/
+
+#include "Benchmark.h"
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juce_initialiser; // the worker pool and the loaders expect one
+    
+    const juce::String filter = (argc > 1) ? argv[1] : "";
+    for (auto* benchmark : Benchmark::getAll())
+    {
+        if (filter.isEmpty() || benchmark->getName().containsIgnoreCase(filter))
+        {
+            benchmark->run();
+        }
+    }
+    return 0;
+}
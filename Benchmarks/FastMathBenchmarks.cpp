@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+
+    FastMathBenchmarks.cpp
+    What FastMath's kernels cost next to the libm calls they replace.
+
+  ==============================================================================
+*/
+
+#include "Benchmark.h"
+
+//==============================================================================
+// Calls a second one core manages for each kernel, one value at a time and a
+// register of lanes at a time, against the standard library's float version
+// on the same inputs: the ranges FastMathTests checks.
+class FastMathBenchmark : public Benchmark
+{
+public:
+    FastMathBenchmark (): Benchmark("FastMath") {}
+
+    void run () override
+    {
+        _storage.allocate(2 * NUM_VALUES + FastMath::Lanes::SIMDNumElements, true); // one spare group to align the start
+        _input  = FastMath::Lanes::getNextSIMDAlignedPtr(_storage.get());
+        _output = _input + NUM_VALUES;
+
+        measure("sin2pi", "std::sin", -1.0f, 2.0f,
+                [] (auto cycles) { return FastMath::sin2pi(cycles); },
+                [] (float cycles) { return std::sin(juce::MathConstants<float>::twoPi * cycles); });
+        measure("cos2pi", "std::cos", -1.0f, 2.0f,
+                [] (auto cycles) { return FastMath::cos2pi(cycles); },
+                [] (float cycles) { return std::cos(juce::MathConstants<float>::twoPi * cycles); });
+        measure("exp2", "std::exp2", -10.0f, 6.0f,
+                [] (auto x) { return FastMath::exp2(x); },
+                [] (float x) { return std::exp2(x); });
+        measure("tanh", "std::tanh", -10.0f, 10.0f,
+                [] (auto x) { return FastMath::tanh(x); },
+                [] (float x) { return std::tanh(x); });
+    }
+
+private:
+    static constexpr int NUM_VALUES = 4096; // input and output stay in L1
+    static constexpr int NUM_CALLS  = 64;
+
+    template <typename Kernel, typename Reference>
+    void measure (const juce::String& name, const juce::String& reference_name, float start, float end,
+                  Kernel&& kernel, Reference&& reference)
+    {
+        using Lanes = FastMath::Lanes;
+        for (int index = 0; index < NUM_VALUES; ++index)
+        {
+            _input[index] = start + (end - start) * static_cast<float>(index) / static_cast<float>(NUM_VALUES);
+        }
+        const auto scalar = timePerCall(NUM_CALLS, [&] {
+            for (int index = 0; index < NUM_VALUES; ++index)
+            {
+                _output[index] = kernel(_input[index]);
+            }
+        });
+        const auto lanes = timePerCall(NUM_CALLS, [&] {
+            for (int index = 0; index < NUM_VALUES; index += static_cast<int>(Lanes::SIMDNumElements))
+            {
+                kernel(Lanes::fromRawArray(_input + index)).copyToRawArray(_output + index);
+            }
+        });
+        const auto libm = timePerCall(NUM_CALLS, [&] {
+            for (int index = 0; index < NUM_VALUES; ++index)
+            {
+                _output[index] = reference(_input[index]);
+            }
+        });
+        report(name + ": " + perSecond(scalar) + " calls a second, " + perSecond(lanes) + " in lanes; "
+               + reference_name + " " + perSecond(libm) + ", " + juce::String(libm / scalar, 2) + "x and "
+               + juce::String(libm / lanes, 2) + "x faster");
+    }
+    static juce::String perSecond (double seconds_per_call)
+    {
+        return juce::String(NUM_VALUES / seconds_per_call / 1.0e6, 1) + "M";
+    }
+
+    juce::HeapBlock<float> _storage;
+    float*                 _input  = nullptr;
+    float*                 _output = nullptr;
+};
+
+static FastMathBenchmark fast_math_benchmark;
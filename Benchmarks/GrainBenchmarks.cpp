@@ -0,0 +1,135 @@
+/*
+  ==============================================================================
+
+    GrainBenchmarks.cpp
+    What the grain cloud costs.
+
+  ==============================================================================
+*/
+
+#include "Benchmark.h"
+
+//==============================================================================
+// Ten seconds of stereo noise, decoded.
+static Sample::Ptr makeNoiseSample ()
+{
+    const auto num_samples = static_cast<int>(10.0 * BenchmarkSynth::SAMPLE_RATE);
+    juce::AudioBuffer<float> audio(2, num_samples);
+    juce::Random random(1);
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        for (int index = 0; index < num_samples; ++index)
+        {
+            audio.setSample(channel, index, 2.0f * random.nextFloat() - 1.0f);
+        }
+    }
+    return new Sample(std::move(audio), BenchmarkSynth::SAMPLE_RATE, "Benchmark");
+}
+
+// Grains of size milliseconds, dense enough for 64 to overlap, starting
+// anywhere from a tenth to nine tenths into the sample.
+static SynthesizerState::SynthesizerInitialState makeCloud (float size)
+{
+    constexpr float num_grains = 64.0f;
+    SynthesizerState::SynthesizerInitialState initial_state;
+    initial_state.grain_density  = num_grains * 1000.0f / size;
+    initial_state.grain_size     = size;
+    initial_state.grain_position = 0.5f;
+    initial_state.grain_jitter   = 0.4f;
+    initial_state.grain_pitch    = 7.0f; // reads between frames
+    return initial_state;
+}
+
+struct CloudLoad
+{
+    double load;          // share of one core, see BenchmarkSynth::getLoad()
+    float  active_grains; // on average, as the engine measured them
+};
+
+// Renders the cloud until it's as dense as it gets, then times it.
+static CloudLoad measureCloud (const Sample& sample, SynthesizerState::SynthesizerInitialState initial_state)
+{
+    constexpr int num_blocks = 375; // a second
+    BenchmarkSynth synth(initial_state);
+    synth.getSynthesizer().setSample(&sample);
+    for (int block = 0; block < num_blocks; ++block)
+    {
+        synth.renderBlock();
+    }
+    const auto load = BenchmarkSynth::getLoad(Benchmark::timePerCall(num_blocks, [&synth] { synth.renderBlock(); }));
+    return { load, synth.getSynthesizer().getGrainLoad().active_grains };
+}
+
+//==============================================================================
+// Every window shape on 1 ms and 500 ms grains, as many overlapping either
+// way: short grains spend their time starting and windowing, long ones
+// reading the sample.
+class GrainWindowBenchmark : public Benchmark
+{
+public:
+    GrainWindowBenchmark (): Benchmark("Grain window") {}
+
+    void run () override
+    {
+        const Sample::Ptr sample = makeNoiseSample();
+        const std::pair<GrainWindowShape, const char*> shapes[] {
+            { GrainWindowShape::HANN_WINDOW,        "hann" },
+            { GrainWindowShape::TUKEY_WINDOW,       "tukey" },
+            { GrainWindowShape::GAUSSIAN_WINDOW,    "gaussian" },
+            { GrainWindowShape::TRAPEZOID_WINDOW,   "trapezoid" },
+            { GrainWindowShape::EXPONENTIAL_WINDOW, "exponential" }
+        };
+        for (const auto& shape : shapes)
+        {
+            const auto short_grains = measure(*sample, shape.first, 1.0f);
+            const auto long_grains  = measure(*sample, shape.first, 500.0f);
+            report(juce::String(shape.second) + ": " + describe(short_grains, "1 ms") + ", " + describe(long_grains, "500 ms")
+                   + ", " + juce::String(short_grains.load / long_grains.load, 2) + "x");
+        }
+    }
+
+private:
+    static CloudLoad measure (const Sample& sample, GrainWindowShape shape, float size)
+    {
+        auto initial_state = makeCloud(size);
+        initial_state.grain_window = shape;
+        return measureCloud(sample, initial_state);
+    }
+    static juce::String describe (const CloudLoad& cloud, const juce::String& size)
+    {
+        return juce::String(cloud.active_grains, 1) + " grains of " + size + " " + percent(cloud.load);
+    }
+};
+
+static GrainWindowBenchmark grain_window_benchmark;
+
+//==============================================================================
+// Each interpolation kernel reading a cloud of 64 overlapping 80 ms grains,
+// and the stereo reads per second one core manages with it.
+class GrainInterpolationBenchmark : public Benchmark
+{
+public:
+    GrainInterpolationBenchmark (): Benchmark("Grain interpolation") {}
+
+    void run () override
+    {
+        const Sample::Ptr sample = makeNoiseSample();
+        const std::pair<GrainInterpolation, const char*> kernels[] {
+            { GrainInterpolation::LINEAR_INTERPOLATION,  "linear" },
+            { GrainInterpolation::HERMITE_INTERPOLATION, "hermite" },
+            { GrainInterpolation::SINC_INTERPOLATION,    "sinc" }
+        };
+        for (const auto& kernel : kernels)
+        {
+            auto initial_state = makeCloud(80.0f);
+            initial_state.grain_interpolation = kernel.first;
+            const auto cloud = measureCloud(*sample, initial_state);
+            // every active grain reads once a sample
+            const auto reads_per_second = cloud.active_grains * BenchmarkSynth::SAMPLE_RATE / cloud.load;
+            report(juce::String(kernel.second) + ": " + juce::String(cloud.active_grains, 1) + " grains " + percent(cloud.load)
+                   + ", " + juce::String(reads_per_second / 1.0e6, 1) + "M reads a second");
+        }
+    }
+};
+
+static GrainInterpolationBenchmark grain_interpolation_benchmark;
@@ -0,0 +1,115 @@
+/*
+  ==============================================================================
+
+    OscillatorBenchmarks.cpp
+    What each way of generating a waveform costs.
+
+  ==============================================================================
+*/
+
+#include "Benchmark.h"
+
+//==============================================================================
+// Band-limited wavetables against PolyBLEP kernels, both oscillators of 64
+// voices on the same waveform.
+class OscillatorModeBenchmark : public Benchmark
+{
+public:
+    OscillatorModeBenchmark (): Benchmark("Oscillator mode") {}
+    
+    void run () override
+    {
+        const std::pair<VoiceWaveType, const char*> wave_types[] {
+            { VoiceWaveType::SAW,      "saw" },
+            { VoiceWaveType::SQUARE,   "square" },
+            { VoiceWaveType::TRIANGLE, "triangle" }
+        };
+        for (const auto& wave_type : wave_types)
+        {
+            const auto table = measure(wave_type.first, OscillatorMode::WAVETABLE_OSC);
+            const auto blep  = measure(wave_type.first, OscillatorMode::POLYBLEP_OSC);
+            report(juce::String(wave_type.second) + ": wavetable " + percent(table) + ", PolyBLEP " + percent(blep)
+                   + ", " + juce::String(blep / table, 2) + "x the table's cost");
+        }
+    }
+    
+private:
+    static constexpr unsigned int NUM_VOICES = 64;
+    static constexpr int          NUM_BLOCKS = 375;
+    
+    double measure (VoiceWaveType wave_type, OscillatorMode oscillator_mode)
+    {
+        auto initial_state = BenchmarkSynth::heldVoices(NUM_VOICES);
+        initial_state.osc_1_wave_type = initial_state.osc_2_wave_type = wave_type;
+        initial_state.oscillator_mode = oscillator_mode;
+        BenchmarkSynth synth(initial_state);
+        synth.playNotes(static_cast<int>(NUM_VOICES));
+        return BenchmarkSynth::getLoad(timePerCall(NUM_BLOCKS, [&synth] { synth.renderBlock(); }));
+    }
+};
+
+static OscillatorModeBenchmark oscillator_mode_benchmark;
+
+//==============================================================================
+// A user wavetable read at a fixed position and while its position sweeps,
+// against the built-in saw's single table, both oscillators of 64 voices.
+class WavetablePositionBenchmark : public Benchmark
+{
+public:
+    WavetablePositionBenchmark (): Benchmark("Wavetable position") {}
+    
+    void run () override
+    {
+        const auto table = makeTable();
+        const auto saw   = measure(VoiceWaveType::SAW, nullptr, false);
+        const auto fixed = measure(VoiceWaveType::USER, table.get(), false);
+        const auto swept = measure(VoiceWaveType::USER, table.get(), true);
+        report("saw table " + percent(saw) + ", user wavetable " + percent(fixed) + " (" + juce::String(fixed / saw, 2)
+               + "x), sweeping its position " + percent(swept) + " (" + juce::String(swept / saw, 2) + "x)");
+    }
+    
+private:
+    static constexpr unsigned int NUM_VOICES = 64;
+    static constexpr int          NUM_BLOCKS = 375;
+    static constexpr int          NUM_FRAMES = 16;
+    
+    // Frames morphing from a sine to a saw.
+    static std::unique_ptr<UserWavetable> makeTable ()
+    {
+        constexpr auto frame_size = UserWavetable::MAX_FRAME_SIZE;
+        std::vector<float> samples(static_cast<size_t>(NUM_FRAMES * frame_size));
+        for (int frame = 0; frame < NUM_FRAMES; ++frame)
+        {
+            const auto morph = static_cast<float>(frame) / static_cast<float>(NUM_FRAMES - 1);
+            for (int index = 0; index < frame_size; ++index)
+            {
+                const auto phase = static_cast<float>(index) / static_cast<float>(frame_size);
+                samples[static_cast<size_t>(frame * frame_size + index)] = (1.0f - morph) * std::sin(juce::MathConstants<float>::twoPi * phase)
+                                                                          + morph * (2.0f * phase - 1.0f);
+            }
+        }
+        return std::make_unique<UserWavetable>(samples.data(), static_cast<int>(samples.size()), "Benchmark");
+    }
+    double measure (VoiceWaveType wave_type, const UserWavetable* table, bool sweep)
+    {
+        auto initial_state = BenchmarkSynth::heldVoices(NUM_VOICES);
+        initial_state.osc_1_wave_type = initial_state.osc_2_wave_type = wave_type;
+        initial_state.wavetable_position = 0.5f;
+        BenchmarkSynth synth(initial_state);
+        synth.getSynthesizer().setUserWavetable(table);
+        synth.playNotes(static_cast<int>(NUM_VOICES));
+        
+        int block = 0;
+        return BenchmarkSynth::getLoad(timePerCall(NUM_BLOCKS, [&synth, &block, sweep]
+        {
+            if (sweep) // back and forth through every frame, a second each way
+            {
+                const auto position = static_cast<float>(block++ % (2 * NUM_BLOCKS)) / static_cast<float>(NUM_BLOCKS);
+                synth.getState().setWavetablePosition((position <= 1.0f) ? position : 2.0f - position);
+            }
+            synth.renderBlock();
+        }));
+    }
+};
+
+static WavetablePositionBenchmark wavetable_position_benchmark;
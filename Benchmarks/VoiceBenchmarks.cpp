@@ -0,0 +1,107 @@
+/*
+  ==============================================================================
+
+    VoiceBenchmarks.cpp
+    What the voices cost as polyphony grows.
+
+  ==============================================================================
+*/
+
+#include "Benchmark.h"
+
+//==============================================================================
+// CPU per voice at 16, 64 and 256 sounding voices, both oscillators on.
+class VoiceCountBenchmark : public Benchmark
+{
+public:
+    VoiceCountBenchmark (): Benchmark("Voice count") {}
+    
+    void run () override
+    {
+        for (auto num_voices : { 16u, 64u, 256u })
+        {
+            BenchmarkSynth synth(BenchmarkSynth::heldVoices(num_voices));
+            synth.playNotes(static_cast<int>(num_voices));
+            
+            const auto load = BenchmarkSynth::getLoad(timePerCall(NUM_BLOCKS, [&synth] { synth.renderBlock(); }));
+            report(juce::String(synth.getSynthesizer().getNumOfActiveVoices()) + " voices: "
+                   + percent(load) + " of a core, " + percent(load / num_voices) + " per voice");
+        }
+    }
+    
+private:
+    static constexpr int NUM_BLOCKS = 375; // a second at 48 kHz
+};
+
+static VoiceCountBenchmark voice_count_benchmark;
+
+//==============================================================================
+// The structure-of-arrays bank against rendering voice by voice, at high polyphony.
+class VoiceRenderModeBenchmark : public Benchmark
+{
+public:
+    VoiceRenderModeBenchmark (): Benchmark("Voice render mode") {}
+    
+    void run () override
+    {
+        for (auto num_voices : { 64u, 256u })
+        {
+            const auto per_voice = measure(VoiceRenderMode::PER_VOICE, num_voices);
+            const auto simd_bank = measure(VoiceRenderMode::SIMD_BANK, num_voices);
+            report(juce::String(num_voices) + " voices: per voice " + percent(per_voice) + ", SIMD bank " + percent(simd_bank)
+                   + ", " + juce::String(per_voice / simd_bank, 2) + "x");
+        }
+    }
+    
+private:
+    static constexpr int NUM_BLOCKS = 375;
+    
+    double measure (VoiceRenderMode render_mode, unsigned int num_voices)
+    {
+        auto initial_state = BenchmarkSynth::heldVoices(num_voices);
+        initial_state.voice_render_mode = render_mode;
+        BenchmarkSynth synth(initial_state);
+        synth.playNotes(static_cast<int>(num_voices));
+        return BenchmarkSynth::getLoad(timePerCall(NUM_BLOCKS, [&synth] { synth.renderBlock(); }));
+    }
+};
+
+static VoiceRenderModeBenchmark voice_render_mode_benchmark;
+
+//==============================================================================
+// 256 voices spread over 1 to 8 render threads, as far as the machine has cores.
+class RenderThreadsBenchmark : public Benchmark
+{
+public:
+    RenderThreadsBenchmark (): Benchmark("Render threads") {}
+    
+    void run () override
+    {
+        const auto num_cpus = static_cast<unsigned int>(juce::jmax(1, juce::SystemStats::getNumCpus()));
+        double single_thread = 0.0;
+        for (auto num_threads : { 1u, 2u, 4u, 8u })
+        {
+            if (num_threads > num_cpus) // setNumOfRenderThreads() would clamp it
+            {
+                report(juce::String(static_cast<int>(num_threads)) + " threads: skipped, more than the machine's "
+                       + juce::String(static_cast<int>(num_cpus)) + " CPUs");
+                continue;
+            }
+            auto initial_state = BenchmarkSynth::heldVoices(NUM_VOICES);
+            initial_state.num_of_render_threads = num_threads;
+            BenchmarkSynth synth(initial_state);
+            synth.playNotes(static_cast<int>(NUM_VOICES));
+            
+            const auto load = BenchmarkSynth::getLoad(timePerCall(NUM_BLOCKS, [&synth] { synth.renderBlock(); }));
+            single_thread   = (num_threads == 1) ? load : single_thread;
+            report(juce::String(static_cast<int>(num_threads)) + " threads: " + percent(load) + " of realtime, "
+                   + juce::String(single_thread / load, 2) + "x");
+        }
+    }
+    
+private:
+    static constexpr unsigned int NUM_VOICES = 256;
+    static constexpr int          NUM_BLOCKS = 375;
+};
+
+static RenderThreadsBenchmark render_threads_benchmark;
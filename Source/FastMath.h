@@ -0,0 +1,214 @@
+/*
+  ==============================================================================
+
+    FastMath.h
+    Polynomial sine, cosine, exp2 and tanh, scalar and SIMD.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <cstring>
+
+//==============================================================================
+/** Replacements for the libm calls of the audio paths, each as a short
+    polynomial that maps straight onto SIMD lanes. The scalar and lane
+    versions run the same operations in the same order, so a per-voice and a
+    SIMD rendering of the same note agree to the last bit wherever the inputs
+    do.
+
+    Maximum errors over the whole input range, against double precision:
+
+        sin2pi, cos2pi   2.5e-7 absolute
+        exp2             1e-7 relative, exact at integer arguments
+        tanh             2.5e-7 absolute, 1e-7 relative below 1/16
+
+    Range reduction rounds with the 1.5 * 2^23 trick, which needs IEEE float
+    semantics: don't build these with -ffast-math. SIMDRegister can neither
+    divide nor convert between float and int, so the lane versions work on
+    the float bits where they have to, and tanh refines a reciprocal
+    estimate with Newton steps; its scalar version does the same.
+*/
+struct FastMath
+{
+    //==============================================================================
+    using Lanes    = juce::dsp::SIMDRegister<float>;
+    using IntLanes = juce::dsp::SIMDRegister<juce::uint32>;
+
+    //==============================================================================
+    // sin(2 pi cycles), the oscillator phase form; exactly 0 at multiples of 1/2.
+    static float sin2pi (float cycles) noexcept
+    {
+        auto x = cycles - round(cycles); // [-1/2, 1/2]
+        x = juce::jmin(x, 0.5f - x);     // folded onto [-1/4, 1/4], where sin(2 pi x) is odd
+        x = juce::jmax(x, -0.5f - x);
+        return sinPolynomial(x);
+    }
+    static float cos2pi (float cycles) noexcept
+    {
+        return sin2pi(cycles - round(cycles) + 0.25f); // reduced first, the quarter cycle is added exactly
+    }
+    // Fractional part, in [0, 1]: 1 only when a tiny negative value rounds up to it.
+    static float wrap (float cycles) noexcept
+    {
+        const auto x = cycles - round(cycles);
+        return (x < 0.0f) ? x + 1.0f : x;
+    }
+    static float exp2 (float x) noexcept
+    {
+        x = juce::jlimit(-126.0f, 127.0f, x);
+        const auto whole = round(x);
+        const auto bits  = static_cast<juce::uint32>(static_cast<int>(whole) + 127) << 23;
+        float scale;
+        std::memcpy(&scale, &bits, sizeof(scale));
+        return exp2Polynomial(x - whole) * scale;
+    }
+    static float tanh (float x) noexcept
+    {
+        if (std::abs(x) < TANH_SERIES_LIMIT)
+        {
+            return tanhSeries(x);
+        }
+        // 1 - 2 / (e + 1) rather than (e - 1) / (e + 1): it reaches 1 exactly
+        const auto e = exp2(juce::jmin(std::abs(x), TANH_LIMIT) * TWO_LOG2_E);
+        const auto magnitude = 1.0f - 2.0f * reciprocal(e + 1.0f);
+        return (x < 0.0f) ? -magnitude : magnitude;
+    }
+
+    //==============================================================================
+    static Lanes sin2pi (Lanes cycles) noexcept
+    {
+        const auto half = Lanes::expand(0.5f);
+        auto x = cycles - round(cycles);
+        x = Lanes::min(x, half - x);
+        x = Lanes::max(x, Lanes::expand(0.0f) - half - x);
+        return sinPolynomial(x);
+    }
+    static Lanes cos2pi (Lanes cycles) noexcept
+    {
+        return sin2pi(cycles - round(cycles) + Lanes::expand(0.25f));
+    }
+    static Lanes wrap (Lanes cycles) noexcept
+    {
+        const auto x = cycles - round(cycles);
+        return x + (Lanes::expand(1.0f) & Lanes::lessThan(x, Lanes::expand(0.0f)));
+    }
+    static Lanes exp2 (Lanes x) noexcept
+    {
+        x = Lanes::min(Lanes::max(x, Lanes::expand(-126.0f)), Lanes::expand(127.0f));
+        const auto whole = round(x);
+        // whole + 127 lands in the low mantissa bits of this sum, the multiply
+        // moves it into the exponent field (there is no shift)
+        const auto biased = toBits(whole + Lanes::expand(127.0f + ROUND_BASE)) - IntLanes::expand(ROUND_BASE_BITS);
+        return exp2Polynomial(x - whole) * fromBits(biased * IntLanes::expand(1u << 23));
+    }
+    static Lanes tanh (Lanes x) noexcept
+    {
+        const auto one       = Lanes::expand(1.0f);
+        const auto absolute  = Lanes::max(x, Lanes::expand(0.0f) - x);
+        const auto e         = exp2(Lanes::min(absolute, Lanes::expand(TANH_LIMIT)) * Lanes::expand(TWO_LOG2_E));
+        const auto magnitude = one - Lanes::expand(2.0f) * reciprocal(e + one);
+        const auto signed_magnitude = magnitude - ((magnitude + magnitude) & Lanes::lessThan(x, Lanes::expand(0.0f))); // m - 2m is -m exactly
+        const auto small     = Lanes::lessThan(absolute, Lanes::expand(TANH_SERIES_LIMIT));
+        return (tanhSeries(x) & small) + (signed_magnitude & ~small);
+    }
+
+private:
+    //==============================================================================
+    static constexpr float        ROUND_MAGIC       = 12582912.0f; // 1.5 * 2^23, its ulp is 1
+    static constexpr float        ROUND_BASE        = 8388608.0f;  // 2^23
+    static constexpr juce::uint32 ROUND_BASE_BITS   = 0x4b000000u;
+    static constexpr juce::uint32 RECIPROCAL_MAGIC  = 0x7ef311c3u;
+    static constexpr float        TWO_LOG2_E        = 2.8853900817779268f;
+    static constexpr float        TANH_LIMIT        = 10.0f;       // tanh is 1 in float beyond
+    static constexpr float        TANH_SERIES_LIMIT = 0.0625f;     // below, e - 1 would cancel
+
+    //==============================================================================
+    // Nearest integer, ties to even; exact for |x| < 2^22.
+    static float round (float x) noexcept
+    {
+        return (x + ROUND_MAGIC) - ROUND_MAGIC;
+    }
+    static Lanes round (Lanes x) noexcept
+    {
+        const auto magic = Lanes::expand(ROUND_MAGIC);
+        return (x + magic) - magic;
+    }
+
+    //==============================================================================
+    // Taylor series of sin(2 pi x) up to x^11, on [-1/4, 1/4].
+    template <typename Value>
+    static Value sinPolynomial (Value x) noexcept
+    {
+        const auto z  = x * juce::MathConstants<float>::twoPi;
+        const auto z2 = z * z;
+        auto poly = z2 * (-1.0f / 39916800.0f) + (1.0f / 362880.0f);
+        poly = poly * z2 - (1.0f / 5040.0f);
+        poly = poly * z2 + (1.0f / 120.0f);
+        poly = poly * z2 - (1.0f / 6.0f);
+        poly = poly * z2 + 1.0f;
+        return z * poly;
+    }
+    // Taylor series of 2^x up to x^7, on [-1/2, 1/2].
+    template <typename Value>
+    static Value exp2Polynomial (Value x) noexcept
+    {
+        auto poly = x * 1.5252733804059840e-5f + 1.5403530393381608e-4f;
+        poly = poly * x + 1.3333558146428443e-3f;
+        poly = poly * x + 9.6181291076284772e-3f;
+        poly = poly * x + 5.5504108664821580e-2f;
+        poly = poly * x + 2.4022650695910071e-1f;
+        poly = poly * x + 6.9314718055994531e-1f;
+        poly = poly * x + 1.0f;
+        return poly;
+    }
+    // x - x^3/3 + 2x^5/15 - 17x^7/315, on [-1/16, 1/16]; x is added last, to a small correction.
+    template <typename Value>
+    static Value tanhSeries (Value x) noexcept
+    {
+        const auto x2 = x * x;
+        auto poly = x2 * (-17.0f / 315.0f) + (2.0f / 15.0f);
+        poly = poly * x2 - (1.0f / 3.0f);
+        return x * x2 * poly + x;
+    }
+
+    //==============================================================================
+    // 1 / x for x >= 1: a bit-level estimate, good to 12 %, and three Newton steps.
+    static float reciprocal (float x) noexcept
+    {
+        juce::uint32 bits;
+        std::memcpy(&bits, &x, sizeof(bits));
+        bits = RECIPROCAL_MAGIC - bits;
+        float estimate;
+        std::memcpy(&estimate, &bits, sizeof(estimate));
+        for (int step = 0; step < 3; ++step)
+        {
+            estimate = estimate * (2.0f - x * estimate);
+        }
+        return estimate;
+    }
+    static Lanes reciprocal (Lanes x) noexcept
+    {
+        const auto two = Lanes::expand(2.0f);
+        auto estimate = fromBits(IntLanes::expand(RECIPROCAL_MAGIC) - toBits(x));
+        for (int step = 0; step < 3; ++step)
+        {
+            estimate = estimate * (two - x * estimate);
+        }
+        return estimate;
+    }
+    static IntLanes toBits (Lanes x) noexcept
+    {
+        IntLanes bits;
+        std::memcpy(&bits, &x, sizeof(bits)); // a register move once compiled
+        return bits;
+    }
+    static Lanes fromBits (IntLanes bits) noexcept
+    {
+        Lanes x;
+        std::memcpy(&x, &bits, sizeof(x));
+        return x;
+    }
+};
@@ -0,0 +1,73 @@
+/*
+  ==============================================================================
+
+    FixedPhase.h
+    32-bit fixed-point oscillator phase, scalar and SIMD.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <cmath>
+
+//==============================================================================
+/** An oscillator phase as a 32-bit fraction of a cycle. Adding the increment
+    wraps by itself and never loses precision, however long a note plays, and
+    increments resolve about 1e-5 Hz, so fine tune, bend and glide land exactly
+    where they are computed to. Changing pitch is an integer add.
+
+    Waveforms are computed from the top 23 bits, everything a float in [0, 1)
+    can hold. SIMDRegister has neither shifts nor int to float conversion, so
+    the lane form keeps those 23 bits (coarse) and the 9 below them (fine, kept
+    at the top of their word so they overflow into the coarse part) in two
+    registers. The coarse part then sits in the mantissa of a float in [1, 2),
+    and becomes a phase with a bit-or and a subtraction. Both forms give
+    bit-identical float phases.
+*/
+struct FixedPhase
+{
+    //==============================================================================
+    using Lanes    = juce::dsp::SIMDRegister<float>;
+    using IntLanes = juce::dsp::SIMDRegister<juce::uint32>;
+
+    static constexpr int          FINE_BITS   = 9;
+    static constexpr juce::uint32 COARSE_MASK = 0x007fffffu; // 23 bits, a float mantissa
+    static constexpr juce::uint32 ONE_BITS    = 0x3f800000u; // 1.0f, exponent only
+
+    //==============================================================================
+    // Phase or increment for a number of cycles, wrapped to one cycle.
+    static juce::uint32 fromCycles (double cycles) noexcept
+    {
+        return static_cast<juce::uint32>(static_cast<juce::uint64>(std::llround((cycles - std::floor(cycles)) * 4294967296.0)));
+    }
+    static double toCycles (juce::uint32 phase) noexcept
+    {
+        return static_cast<double>(phase) / 4294967296.0;
+    }
+    static float toFloat (juce::uint32 phase) noexcept
+    {
+        return static_cast<float>(phase >> FINE_BITS) * (1.0f / static_cast<float>(COARSE_MASK + 1));
+    }
+
+    //==============================================================================
+    static juce::uint32 coarse (juce::uint32 phase) noexcept { return phase >> FINE_BITS; }
+    static juce::uint32 fine   (juce::uint32 phase) noexcept { return phase << (32 - FINE_BITS); }
+    static juce::uint32 join   (juce::uint32 coarse, juce::uint32 fine) noexcept
+    {
+        return (coarse << FINE_BITS) | (fine >> (32 - FINE_BITS));
+    }
+
+    //==============================================================================
+    static void advance (IntLanes& coarse, IntLanes& fine, IntLanes coarse_increment, IntLanes fine_increment) noexcept
+    {
+        fine = fine + fine_increment;
+        const auto carry = IntLanes::lessThan(fine, fine_increment); // the fine part wrapped
+        coarse = (coarse + coarse_increment + (IntLanes::expand(1u) & carry)) & IntLanes::expand(COARSE_MASK);
+    }
+    static Lanes toFloat (IntLanes coarse) noexcept
+    {
+        return (Lanes::expand(0.0f) | (coarse | IntLanes::expand(ONE_BITS))) - Lanes::expand(1.0f);
+    }
+};
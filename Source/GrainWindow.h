@@ -0,0 +1,98 @@
+/*
+  ==============================================================================
+
+    GrainWindow.h
+    Amplitude windows of grains, tabulated once and shared by all of them.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <functional>
+#include <vector>
+
+//==============================================================================
+/** The gain of a grain over its length, stored as a table so rendering a
+    grain costs an interpolated lookup per sample instead of a cos() or an
+    exp().
+
+    Tapered windows hold full gain across their middle, for as long as the
+    taper leaves: their table is the window with the longest edges, which
+    is read at the phase mapped onto its rising half, mirrored for the
+    falling one. A taper of 1 plays the table as it is, smaller ones steepen
+    both edges, so one table covers every taper.
+
+    A GrainWindow is immutable once built; any number of grains and plugin
+    instances read it without synchronisation.
+*/
+class GrainWindow
+{
+public:
+    //==============================================================================
+    static constexpr int SIZE = 1024;
+    // The shortest share of a grain a tapered edge may take, shorter ones click.
+    static constexpr float MIN_TAPER = 0.01f;
+
+    // Gain at the phase through the grain, 0 to 1.
+    using ShapeFunction = std::function<double(double)>;
+
+    //==============================================================================
+    // Tabulates the shape, allocates: build off the audio thread. Tapered
+    // shapes must be symmetric around the middle.
+    explicit GrainWindow (const ShapeFunction& shape, bool is_tapered = false):
+        _is_tapered(is_tapered)
+    {
+        _data.resize(static_cast<size_t>(SIZE + 1));
+        for (int index = 0; index <= SIZE; ++index) // guard point included, interpolation never reads past it
+        {
+            _data[static_cast<size_t>(index)] = static_cast<float>(shape(static_cast<double>(index) / SIZE));
+        }
+    }
+
+    //==============================================================================
+    bool isTapered () const noexcept
+    {
+        return _is_tapered;
+    }
+    // Writes the gains of num_samples samples starting at phase, step apart,
+    // every stride floats; taper is the share of the grain both edges of a
+    // tapered window take together, ignored by the others.
+    void render (float* gains, int num_samples, float phase, float step, float taper, int stride = 1) const noexcept
+    {
+        const auto* table = _data.data();
+        if (! _is_tapered)
+        {
+            for (int sample = 0; sample < num_samples; ++sample)
+            {
+                gains[sample * stride] = lookup(table, phase);
+                phase += step;
+            }
+            return;
+        }
+        const auto edge_scale = 1.0f / juce::jmax(MIN_TAPER, taper);
+        for (int sample = 0; sample < num_samples; ++sample)
+        {
+            const auto edge = juce::jmin(phase, 1.0f - phase) * edge_scale; // distance from the nearer end
+            gains[sample * stride] = lookup(table, juce::jmin(0.5f, edge));
+            phase += step;
+        }
+    }
+
+private:
+    //==============================================================================
+    static float lookup (const float* table, float phase) noexcept
+    {
+        const auto position = juce::jlimit(0.0f, static_cast<float>(SIZE), phase * SIZE); // rounding may step just outside
+        const auto index    = juce::jmin(static_cast<int>(position), SIZE - 1);
+        const auto fraction = position - static_cast<float>(index);
+        return table[index] + fraction * (table[index + 1] - table[index]);
+    }
+
+    //==============================================================================
+    std::vector<float> _data; // SIZE + 1 points, phase 0 to 1
+    bool               _is_tapered;
+
+    JUCE_DECLARE_NON_COPYABLE (GrainWindow)
+};
@@ -45,14 +45,33 @@ void GGranulaAudioProcessorEditor::resized()
 
 bool GGranulaAudioProcessorEditor::isInterestedInFileDrag(const StringArray& files)
 {
-    return true;
+    for (const auto& file : files)
+    {
+        if (audioProcessor.canLoadSample(juce::File(file)) || WavetableLoader::canLoad(juce::File(file)))
+        {
+            return true;
+        }
+    }
+    return false;
 }
 
+// Files dropped on the oscillators become their wavetable, anywhere else the sample.
 void GGranulaAudioProcessorEditor::filesDropped(const juce::StringArray& files, int x, int y)
 {
-    std::cout << "filesDropped: " << x << " " << y << std::endl;
-    for (auto file : files)
+    const auto oscillators  = getLocalArea(&main_panel.osc_panel, main_panel.osc_panel.getLocalBounds());
+    const auto as_wavetable = oscillators.contains(x, y);
+    for (const auto& path : files)
     {
-        std::cout << "file: " << file << std::endl;
+        const juce::File file(path);
+        if (as_wavetable && WavetableLoader::canLoad(file))
+        {
+            audioProcessor.loadWavetable(file); // one file at a time, the first one wins
+            return;
+        }
+        if (!as_wavetable && audioProcessor.canLoadSample(file))
+        {
+            audioProcessor.loadSample(file);
+            return;
+        }
     }
 }
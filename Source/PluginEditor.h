@@ -160,6 +160,9 @@ private:
             
             combo_box.addItem("sin", 1);
             combo_box.addItem("saw", 2);
+            combo_box.addItem("square", 3);
+            combo_box.addItem("triangle", 4);
+            combo_box.addItem("user", 5);
             combo_box.setSelectedId(1);
             combo_box.addListener(this);
             addAndMakeVisible(combo_box);
@@ -25,13 +25,45 @@ GGranulaAudioProcessor::GGranulaAudioProcessor()
 #endif
 {
     const juce::StringArray transpose("-2", "-1", "0", "+1", "+2");
-    const juce::StringArray waves("Sine", "Sawtooth");
+    const juce::StringArray waves("Sine", "Sawtooth", "Square", "Triangle", "User");
     
     addParameter(osc_1_transpose = new juce::AudioParameterChoice("osc_1_transpose", "OSC #1 - Transpose", transpose, 2));
     addParameter(osc_1_wave = new juce::AudioParameterChoice("osc_1_wave", "OSC #1 - Waveform", waves, 0));
+    addParameter(osc_1_fine = new juce::AudioParameterFloat("osc_1_fine", "OSC #1 - Fine", juce::NormalisableRange<float>(-100.0f, 100.0f, 0.1f), synthesizerState->getFineTune(SynthOSC::FIRST_OSC)));
+    addParameter(osc_1_unison_voices = new juce::AudioParameterInt("osc_1_unison_voices", "OSC #1 - Unison voices", 1, Voice::MAX_UNISON, synthesizerState->getUnisonVoices(SynthOSC::FIRST_OSC)));
+    addParameter(osc_1_unison_detune = new juce::AudioParameterFloat("osc_1_unison_detune", "OSC #1 - Unison detune", juce::NormalisableRange<float>(0.0f, 100.0f, 0.1f), synthesizerState->getUnisonDetune(SynthOSC::FIRST_OSC)));
+    addParameter(osc_1_unison_spread = new juce::AudioParameterFloat("osc_1_unison_spread", "OSC #1 - Unison spread", juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), synthesizerState->getUnisonSpread(SynthOSC::FIRST_OSC)));
     
     addParameter(osc_2_transpose = new juce::AudioParameterChoice("osc_2_transpose", "OSC #2 - Transpose", transpose, 2));
     addParameter(osc_2_wave = new juce::AudioParameterChoice("osc_2_wave", "OSC #2 - Waveform", waves, 0));
+    addParameter(osc_2_fine = new juce::AudioParameterFloat("osc_2_fine", "OSC #2 - Fine", juce::NormalisableRange<float>(-100.0f, 100.0f, 0.1f), synthesizerState->getFineTune(SynthOSC::SECOND_OSC)));
+    addParameter(osc_2_unison_voices = new juce::AudioParameterInt("osc_2_unison_voices", "OSC #2 - Unison voices", 1, Voice::MAX_UNISON, synthesizerState->getUnisonVoices(SynthOSC::SECOND_OSC)));
+    addParameter(osc_2_unison_detune = new juce::AudioParameterFloat("osc_2_unison_detune", "OSC #2 - Unison detune", juce::NormalisableRange<float>(0.0f, 100.0f, 0.1f), synthesizerState->getUnisonDetune(SynthOSC::SECOND_OSC)));
+    addParameter(osc_2_unison_spread = new juce::AudioParameterFloat("osc_2_unison_spread", "OSC #2 - Unison spread", juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), synthesizerState->getUnisonSpread(SynthOSC::SECOND_OSC)));
+    addParameter (wave_crossfade = new juce::AudioParameterFloat ("wave_crossfade",
+                                                                  "OSC - Waveform crossfade",
+                                                                  juce::NormalisableRange<float>(0.0f, 50.0f, 0.1f),
+                                                                  synthesizerState->getWaveCrossfade()));
+    addParameter (osc_mode = new juce::AudioParameterChoice ("osc_mode",
+                                                             "OSC - Mode",
+                                                             juce::StringArray("Wavetable", "PolyBLEP"),
+                                                             static_cast<int>(synthesizerState->getOscillatorMode())));
+    addParameter (pulse_width = new juce::AudioParameterFloat ("pulse_width",
+                                                               "OSC - Pulse width",
+                                                               juce::NormalisableRange<float>(0.05f, 0.95f, 0.01f),
+                                                               synthesizerState->getPulseWidth()));
+    addParameter (glide_time = new juce::AudioParameterFloat ("glide_time",
+                                                              "OSC - Glide",
+                                                              juce::NormalisableRange<float>(0.0f, 2000.0f, 1.0f, 0.5f),
+                                                              synthesizerState->getGlideTime()));
+    addParameter (fm_index = new juce::AudioParameterFloat ("fm_index",
+                                                            "FM - Index",
+                                                            juce::NormalisableRange<float>(0.0f, 10.0f, 0.01f, 0.5f),
+                                                            synthesizerState->getFMIndex()));
+    addParameter (wavetable_position = new juce::AudioParameterFloat ("wavetable_position",
+                                                                      "Wavetable - Position",
+                                                                      juce::NormalisableRange<float>(0.0f, 1.0f), // unstepped, it scans up to 256 frames
+                                                                      synthesizerState->getWavetablePosition()));
     
     addParameter (amp_attack = new juce::AudioParameterFloat ("amp_attack",
                                                               "AMP - Attack",
@@ -49,6 +81,10 @@ GGranulaAudioProcessor::GGranulaAudioProcessor()
                                                                "AMP - Release",
                                                                juce::NormalisableRange<float>(0.01f, 20.0f, 0.01f, 0.5f),
                                                                synthesizerState->getAmpADSR(ADSRStages::RELEASE)));
+    addParameter (amp_pan = new juce::AudioParameterFloat ("amp_pan",
+                                                           "AMP - Pan",
+                                                           juce::NormalisableRange<float>(-1.0f, 1.0f, 0.01f),
+                                                           synthesizerState->getAmpPan()));
     
     addParameter (filter_cutoff = new juce::AudioParameterFloat ("filter_cutoff",
                                                                "Filter - Cutoff",
@@ -58,6 +94,68 @@ GGranulaAudioProcessor::GGranulaAudioProcessor()
                                                             "Filter - Q",
                                                             juce::NormalisableRange<float>(0.1f, 12.0f, 0.1f, 0.5f),
                                                             synthesizerState->getFilterQ()));
+    addParameter (filter_mode = new juce::AudioParameterChoice ("filter_mode",
+                                                                "Filter - Mode",
+                                                                juce::StringArray("Global", "Per voice"),
+                                                                static_cast<int>(synthesizerState->getFilterMode())));
+    addParameter (filter_key_tracking = new juce::AudioParameterFloat ("filter_key_tracking",
+                                                                       "Filter - Key tracking",
+                                                                       juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f),
+                                                                       synthesizerState->getFilterKeyTracking()));
+    addParameter (filter_velocity = new juce::AudioParameterFloat ("filter_velocity",
+                                                                   "Filter - Velocity",
+                                                                   juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f),
+                                                                   synthesizerState->getFilterVelocity()));
+    
+    addParameter (voice_steal = new juce::AudioParameterChoice ("voice_steal",
+                                                                "Voices - Steal",
+                                                                juce::StringArray("Oldest", "Quietest", "Lowest stage", "Same note"),
+                                                                static_cast<int>(synthesizerState->getVoiceStealPolicy())));
+    
+    addParameter (grain_density = new juce::AudioParameterFloat ("grain_density",
+                                                                 "Grains - Density",
+                                                                 juce::NormalisableRange<float>(0.0f, 64000.0f, 0.1f, 0.11f), // per second, 0 is off; the pool caps the overlap
+                                                                 synthesizerState->getGrainParam(GrainParam::GRAIN_DENSITY)));
+    addParameter (grain_size = new juce::AudioParameterFloat ("grain_size",
+                                                              "Grains - Size",
+                                                              juce::NormalisableRange<float>(1.0f, 1000.0f, 0.1f, 0.4f), // milliseconds
+                                                              synthesizerState->getGrainParam(GrainParam::GRAIN_SIZE)));
+    addParameter (grain_position = new juce::AudioParameterFloat ("grain_position",
+                                                                  "Grains - Position",
+                                                                  juce::NormalisableRange<float>(0.0f, 1.0f), // unstepped, samples may be minutes long
+                                                                  synthesizerState->getGrainParam(GrainParam::GRAIN_POSITION)));
+    addParameter (grain_jitter = new juce::AudioParameterFloat ("grain_jitter",
+                                                                "Grains - Position jitter",
+                                                                juce::NormalisableRange<float>(0.0f, 1.0f, 0.0f, 0.5f),
+                                                                synthesizerState->getGrainParam(GrainParam::GRAIN_JITTER)));
+    addParameter (grain_pitch = new juce::AudioParameterFloat ("grain_pitch",
+                                                               "Grains - Pitch",
+                                                               juce::NormalisableRange<float>(-24.0f, 24.0f, 0.01f), // semitones
+                                                               synthesizerState->getGrainParam(GrainParam::GRAIN_PITCH)));
+    addParameter (grain_pan = new juce::AudioParameterFloat ("grain_pan",
+                                                             "Grains - Pan",
+                                                             juce::NormalisableRange<float>(-1.0f, 1.0f, 0.01f),
+                                                             synthesizerState->getGrainParam(GrainParam::GRAIN_PAN)));
+    addParameter (grain_pan_spread = new juce::AudioParameterFloat ("grain_pan_spread",
+                                                                    "Grains - Pan spread",
+                                                                    juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f),
+                                                                    synthesizerState->getGrainParam(GrainParam::GRAIN_PAN_SPREAD)));
+    addParameter (grain_level = new juce::AudioParameterFloat ("grain_level",
+                                                               "Grains - Level",
+                                                               juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f),
+                                                               synthesizerState->getGrainParam(GrainParam::GRAIN_LEVEL)));
+    addParameter (grain_window = new juce::AudioParameterChoice ("grain_window",
+                                                                 "Grains - Window",
+                                                                 juce::StringArray("Hann", "Tukey", "Gaussian", "Trapezoid", "Exponential"),
+                                                                 static_cast<int>(synthesizerState->getGrainWindow())));
+    addParameter (grain_taper = new juce::AudioParameterFloat ("grain_taper",
+                                                               "Grains - Taper",
+                                                               juce::NormalisableRange<float>(GrainWindow::MIN_TAPER, 1.0f, 0.01f), // Tukey and trapezoid
+                                                               synthesizerState->getGrainParam(GrainParam::GRAIN_TAPER)));
+    addParameter (grain_interpolation = new juce::AudioParameterChoice ("grain_interpolation",
+                                                                        "Grains - Interpolation",
+                                                                        juce::StringArray("Linear", "Hermite", "Sinc"),
+                                                                        static_cast<int>(synthesizerState->getGrainInterpolation())));
 }
 
 GGranulaAudioProcessor::~GGranulaAudioProcessor()
@@ -131,6 +229,8 @@ void GGranulaAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlo
 {
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
+    synthesizer.setOversamplingOrder(isNonRealtime() ? synthesizerState->getOfflineOversampling()
+                                                     : synthesizerState->getRealtimeOversampling());
     synthesizer.prepare({
         .juce_spec = {
             .sampleRate       = sampleRate,
@@ -138,6 +238,7 @@ void GGranulaAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlo
             .numChannels      = static_cast<juce::uint32>(getTotalNumOutputChannels())
         }
     });
+    setLatencySamples(synthesizer.getLatencyInSamples());
 }
 
 void GGranulaAudioProcessor::releaseResources()
@@ -147,6 +248,79 @@ void GGranulaAudioProcessor::releaseResources()
     synthesizer.reset();
 }
 
+void GGranulaAudioProcessor::setNumOfVoices(unsigned int num_of_voices)
+{
+    // resizing the voice pool allocates, keep the audio callback out while it happens
+    suspendProcessing(true);
+    synthesizerState->setNumOfVoices(num_of_voices);
+    synthesizer.setNumOfVoices(num_of_voices);
+    suspendProcessing(false);
+}
+
+void GGranulaAudioProcessor::setNumOfRenderThreads(unsigned int num_of_threads)
+{
+    // starting and stopping worker threads must not race the audio callback either
+    suspendProcessing(true);
+    synthesizerState->setNumOfRenderThreads(num_of_threads);
+    synthesizer.setNumOfRenderThreads(num_of_threads);
+    suspendProcessing(false);
+}
+
+void GGranulaAudioProcessor::setOversampling(unsigned int realtime_order, unsigned int offline_order)
+{
+    // a new factor reallocates the oversampler and changes the latency, so it
+    // goes through prepareToPlay with the audio callback kept out
+    suspendProcessing(true);
+    synthesizerState->setRealtimeOversampling(realtime_order);
+    synthesizerState->setOfflineOversampling(offline_order);
+    if (getSampleRate() > 0.0) // not prepared yet otherwise, the host's prepareToPlay will pick it up
+    {
+        prepareToPlay(getSampleRate(), getBlockSize());
+    }
+    suspendProcessing(false);
+}
+
+void GGranulaAudioProcessor::setNonRealtime(bool is_non_realtime) noexcept
+{
+    const auto changed = (is_non_realtime != isNonRealtime());
+    AudioProcessor::setNonRealtime(is_non_realtime);
+    
+    // not every host prepares again around an offline render, switch factors here
+    if (changed && getSampleRate() > 0.0
+        && synthesizerState->getRealtimeOversampling() != synthesizerState->getOfflineOversampling())
+    {
+        suspendProcessing(true);
+        prepareToPlay(getSampleRate(), getBlockSize());
+        suspendProcessing(false);
+    }
+}
+
+void GGranulaAudioProcessor::loadWavetable(const juce::File& file)
+{
+    wavetableLoader.load(file); // never waits, the table shows up in a later block
+}
+
+void GGranulaAudioProcessor::loadSample(const juce::File& file)
+{
+    sampleLoader.load(file); // never waits, even for minutes of audio
+}
+
+bool GGranulaAudioProcessor::canLoadSample(const juce::File& file) const
+{
+    return sampleLoader.canLoad(file);
+}
+
+GrainEngine::Load GGranulaAudioProcessor::getGrainLoad() const
+{
+    return synthesizer.getGrainLoad(); // atomics, never waits on the audio thread
+}
+
+void GGranulaAudioProcessor::setVoiceRenderMode(VoiceRenderMode render_mode)
+{
+    // voices keep their state outside either render path, so this can change mid-note
+    synthesizerState->setVoiceRenderMode(render_mode);
+}
+
 #ifndef JucePlugin_PreferredChannelConfigurations
 bool GGranulaAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
 {
@@ -174,6 +348,7 @@ bool GGranulaAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts)
 void GGranulaAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
     juce::ScopedNoDenormals noDenormals;
+    RealtimeAllocationTripwire allocationTripwire; // debug builds assert if anything below allocates
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
     
@@ -188,37 +363,62 @@ void GGranulaAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juc
         buffer.clear(i, 0, buffer.getNumSamples());
     }
     
+    // freshly loaded tables and samples go in before anything renders, the loaders free the old ones
+    userWavetables.update([this](const UserWavetable* table) { synthesizer.setUserWavetable(table); });
+    samples.updateKeepingPrevious([this](const Sample::Ptr* sample) { synthesizer.setSample(sample->get()); });
+    
     synthesizerState->setTranspose(SynthOSC::FIRST_OSC,  osc_1_transpose->getCurrentChoiceName());
     synthesizerState->setTranspose(SynthOSC::SECOND_OSC, osc_2_transpose->getCurrentChoiceName());
+    synthesizerState->setWaveCrossfade(wave_crossfade->get()); // before the waveforms, a switch uses it
+    synthesizerState->setOscillatorMode(static_cast<OscillatorMode>(osc_mode->getIndex()));
+    synthesizerState->setPulseWidth(pulse_width->get());
+    synthesizerState->setFineTune(SynthOSC::FIRST_OSC,  osc_1_fine->get());
+    synthesizerState->setFineTune(SynthOSC::SECOND_OSC, osc_2_fine->get());
+    synthesizerState->setGlideTime(glide_time->get());
+    synthesizerState->setUnisonVoices(SynthOSC::FIRST_OSC,  osc_1_unison_voices->get());
+    synthesizerState->setUnisonVoices(SynthOSC::SECOND_OSC, osc_2_unison_voices->get());
+    synthesizerState->setUnisonDetune(SynthOSC::FIRST_OSC,  osc_1_unison_detune->get());
+    synthesizerState->setUnisonDetune(SynthOSC::SECOND_OSC, osc_2_unison_detune->get());
+    synthesizerState->setUnisonSpread(SynthOSC::FIRST_OSC,  osc_1_unison_spread->get());
+    synthesizerState->setUnisonSpread(SynthOSC::SECOND_OSC, osc_2_unison_spread->get());
+    synthesizerState->setFMIndex(fm_index->get());
+    synthesizerState->setWavetablePosition(wavetable_position->get());
     synthesizerState->setWaveType(SynthOSC::FIRST_OSC,  osc_1_wave->getCurrentChoiceName());
     synthesizerState->setWaveType(SynthOSC::SECOND_OSC, osc_2_wave->getCurrentChoiceName());
     synthesizerState->setAmpADSR(ADSRStages::ATTACK,  amp_attack->get());
     synthesizerState->setAmpADSR(ADSRStages::DECAY,   amp_decay->get());
     synthesizerState->setAmpADSR(ADSRStages::SUSTAIN, amp_sustain->get());
     synthesizerState->setAmpADSR(ADSRStages::RELEASE, amp_release->get());
+    synthesizerState->setAmpPan(amp_pan->get());
     synthesizerState->setFilterCutoff(filter_cutoff->get());
     synthesizerState->setFilterQ(filter_q->get());
+    synthesizerState->setFilterMode(static_cast<FilterMode>(filter_mode->getIndex()));
+    synthesizerState->setFilterKeyTracking(filter_key_tracking->get());
+    synthesizerState->setFilterVelocity(filter_velocity->get());
+    synthesizerState->setVoiceStealPolicy(static_cast<VoiceStealPolicy>(voice_steal->getIndex()));
+    synthesizerState->setGrainParam(GrainParam::GRAIN_DENSITY,    grain_density->get());
+    synthesizerState->setGrainParam(GrainParam::GRAIN_SIZE,       grain_size->get());
+    synthesizerState->setGrainParam(GrainParam::GRAIN_POSITION,   grain_position->get());
+    synthesizerState->setGrainParam(GrainParam::GRAIN_JITTER,     grain_jitter->get());
+    synthesizerState->setGrainParam(GrainParam::GRAIN_PITCH,      grain_pitch->get());
+    synthesizerState->setGrainParam(GrainParam::GRAIN_PAN,        grain_pan->get());
+    synthesizerState->setGrainParam(GrainParam::GRAIN_PAN_SPREAD, grain_pan_spread->get());
+    synthesizerState->setGrainParam(GrainParam::GRAIN_LEVEL,      grain_level->get());
+    synthesizerState->setGrainParam(GrainParam::GRAIN_TAPER,      grain_taper->get());
+    synthesizerState->setGrainWindow(static_cast<GrainWindowShape>(grain_window->getIndex()));
+    synthesizerState->setGrainInterpolation(static_cast<GrainInterpolation>(grain_interpolation->getIndex()));
 
-    // This is the place where you'd normally do the guts of your plugin's
-    // audio processing...
-    // Make sure to reset the state if your inner loop is processing
-    // the samples and the outer loop is handling the channels.
-    // Alternatively, you can process the samples with the channels
-    // interleaved by keeping the same state.
-    for (auto message: midiMessages) {
-        if (message.getMessage().isNoteOn())
-        {
-            synthesizer.noteOn(message.getMessage());
-        } else if (message.getMessage().isNoteOff())
-        {
-            synthesizer.noteOff(message.getMessage());
-        }
-    }
+    // MIDI events are applied at their sample position inside the block
     dsp::AudioBlock<BufferData> block(buffer);
     dsp::ProcessContextReplacing<BufferData> context(block);
-    synthesizer.process({
+    synthesizer.renderNextBlock({
         .juce_context = context
-    });
+    }, midiMessages);
+    if (! synthesizer.isReadingReplacedSample())
+    {
+        samples.releasePrevious(); // the grains on the old sample have faded out
+    }
+    sampleLoader.prefetch(synthesizer.getUpcomingGrainFrames()); // mapped samples only, the loader reads ahead
 }
 
 //==============================================================================
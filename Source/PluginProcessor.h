@@ -10,6 +10,20 @@
 
 #include <JuceHeader.h>
 #include <algorithm>
+#include <array>
+#include <memory>
+#include <vector>
+#include "FastMath.h"
+#include "FixedPhase.h"
+#include "GrainWindow.h"
+#include "PolyBLEP.h"
+#include "RealtimeSwap.h"
+#include "RealtimeWorkerPool.h"
+#include "Sample.h"
+#include "SampleLoader.h"
+#include "SampleReader.h"
+#include "Wavetable.h"
+#include "WavetableLoader.h"
 
 //==============================================================================
 using BufferData = float;
@@ -27,7 +41,18 @@ enum ADSRStages
 enum VoiceWaveType
 {
     SIN,
-    SAW
+    SAW,
+    SQUARE, // pulse, see the pulse width
+    TRIANGLE,
+    USER    // a wavetable loaded from a file, silent until one is
+};
+
+//==============================================================================
+// How the non-sine waveforms are generated
+enum OscillatorMode
+{
+    WAVETABLE_OSC, // shared band-limited tables
+    POLYBLEP_OSC   // analytic, corrected around the discontinuities
 };
 
 //==============================================================================
@@ -40,6 +65,29 @@ enum VoiceTranspose
     PLUS_TWO_OCTAVES
 };
 
+//==============================================================================
+enum VoiceStealPolicy
+{
+    OLDEST,
+    QUIETEST,
+    LOWEST_STAGE,
+    SAME_NOTE
+};
+
+//==============================================================================
+enum VoiceRenderMode
+{
+    PER_VOICE,
+    SIMD_BANK
+};
+
+//==============================================================================
+enum FilterMode
+{
+    GLOBAL_FILTER,
+    PER_VOICE_FILTER
+};
+
 //==============================================================================
 enum SynthOSC
 {
@@ -47,6 +95,41 @@ enum SynthOSC
     SECOND_OSC
 };
 
+//==============================================================================
+// Settings of the grain cloud, see GrainEngine
+enum GrainParam
+{
+    GRAIN_DENSITY,    // grains started per second, 0 stops the cloud
+    GRAIN_SIZE,       // milliseconds
+    GRAIN_POSITION,   // where in the sample grains start, 0 to 1
+    GRAIN_JITTER,     // random offset around the position, as a share of the sample
+    GRAIN_PITCH,      // semitones
+    GRAIN_PAN,        // -1 is hard left, 1 hard right
+    GRAIN_PAN_SPREAD, // random pan around it, 1 may throw a grain across the whole field
+    GRAIN_LEVEL,      // linear gain of the whole cloud
+    GRAIN_TAPER       // share of a grain the edges of a Tukey or trapezoid window take
+};
+
+//==============================================================================
+// Amplitude window of every grain, see GrainEngine::getSharedWindow()
+enum GrainWindowShape
+{
+    HANN_WINDOW,
+    TUKEY_WINDOW,      // Hann edges around a flat top, see the taper
+    GAUSSIAN_WINDOW,
+    TRAPEZOID_WINDOW,  // linear edges, see the taper
+    EXPONENTIAL_WINDOW // a quick attack into an exponential decay
+};
+
+//==============================================================================
+// How grains read the sample between its frames, see SampleReader
+enum GrainInterpolation
+{
+    LINEAR_INTERPOLATION,
+    HERMITE_INTERPOLATION,
+    SINC_INTERPOLATION     // for offline renders, costs several times the others
+};
+
 //==============================================================================
 class SynthesizerState
 {
@@ -54,13 +137,31 @@ public:
     using ADSRParam = float;
     using Frequency = float;
     using QFactor   = float;
+    using PanParam  = float;
     
     //==============================================================================
     using TransposeHandler    = std::function<void(VoiceTranspose)>;
     using WaveTypeHandler     = std::function<void(VoiceWaveType)>;
+    using CrossfadeHandler    = std::function<void(float)>;
+    using PulseWidthHandler   = std::function<void(float)>;
+    using OscModeHandler      = std::function<void(OscillatorMode)>;
+    using FineTuneHandler     = std::function<void(float)>;
+    using GlideHandler        = std::function<void(float)>;
+    using UnisonVoicesHandler = std::function<void(int)>;
+    using UnisonAmountHandler = std::function<void(float)>;
+    using FMIndexHandler      = std::function<void(float)>;
+    using PositionHandler     = std::function<void(float)>;
     using ADSRHandler         = std::function<void(ADSRParam)>;
+    using PanHandler          = std::function<void(PanParam)>;
     using FilterCutoffhandler = std::function<void(Frequency)>;
     using FilterQHandler      = std::function<void(QFactor)>;
+    using FilterModeHandler   = std::function<void(FilterMode)>;
+    using FilterAmountHandler = std::function<void(float)>;
+    using StealPolicyHandler  = std::function<void(VoiceStealPolicy)>;
+    using RenderModeHandler   = std::function<void(VoiceRenderMode)>;
+    using GrainHandler        = std::function<void(float)>;
+    using GrainWindowHandler  = std::function<void(GrainWindowShape)>;
+    using InterpolationHandler = std::function<void(GrainInterpolation)>;
     
     //==============================================================================
     struct SynthesizerInitialState
@@ -70,13 +171,47 @@ public:
         VoiceTranspose osc_2_transpose = VoiceTranspose::NO_TRANSPOSE;
         VoiceWaveType  osc_1_wave_type = VoiceWaveType::SIN;
         VoiceWaveType  osc_2_wave_type = VoiceWaveType::SAW;
+        float          wave_crossfade  = 5.0f;
+        float          pulse_width     = 0.5f;
+        OscillatorMode oscillator_mode = OscillatorMode::WAVETABLE_OSC;
+        float          osc_1_fine_tune = 0.0f;
+        float          osc_2_fine_tune = 0.0f;
+        float          glide_time      = 0.0f;
+        int            osc_1_unison_voices = 1;
+        int            osc_2_unison_voices = 1;
+        float          osc_1_unison_detune = 20.0f;
+        float          osc_2_unison_detune = 20.0f;
+        float          osc_1_unison_spread = 0.5f;
+        float          osc_2_unison_spread = 0.5f;
+        float          fm_index        = 0.0f;
+        float          wavetable_position = 0.0f;
         ADSRParam      amp_attack      = 0.1f;
         ADSRParam      amp_decay       = 0.1f;
         ADSRParam      amp_sustain     = 0.8f;
         ADSRParam      amp_release     = 0.5f;
+        PanParam       amp_pan         = 0.0f;
         Frequency      filter_cutoff   = 100.0f;
         QFactor        filter_q        = 1.0f;
+        FilterMode     filter_mode     = FilterMode::GLOBAL_FILTER;
+        float          filter_key_tracking = 0.0f;
+        float          filter_velocity     = 0.0f;
         unsigned int   num_of_voices   = 4;
+        unsigned int   num_of_render_threads = 1;
+        unsigned int   realtime_oversampling = 0;
+        unsigned int   offline_oversampling  = 0;
+        VoiceStealPolicy voice_steal_policy = VoiceStealPolicy::OLDEST;
+        VoiceRenderMode  voice_render_mode  = VoiceRenderMode::SIMD_BANK;
+        float          grain_density    = 0.0f;
+        float          grain_size       = 80.0f;
+        float          grain_position   = 0.0f;
+        float          grain_jitter     = 0.0f;
+        float          grain_pitch      = 0.0f;
+        float          grain_pan        = 0.0f;
+        float          grain_pan_spread = 0.0f;
+        float          grain_level      = 0.5f;
+        float          grain_taper      = 0.5f;
+        GrainWindowShape grain_window   = GrainWindowShape::HANN_WINDOW;
+        GrainInterpolation grain_interpolation = GrainInterpolation::HERMITE_INTERPOLATION;
     };
     
     SynthesizerState(SynthesizerInitialState initial_state = SynthesizerInitialState()):
@@ -84,13 +219,47 @@ public:
         osc_2_transpose(initial_state.osc_2_transpose),
         osc_1_wave_type(initial_state.osc_1_wave_type),
         osc_2_wave_type(initial_state.osc_2_wave_type),
+        wave_crossfade(initial_state.wave_crossfade),
+        pulse_width(initial_state.pulse_width),
+        oscillator_mode(initial_state.oscillator_mode),
+        osc_1_fine_tune(initial_state.osc_1_fine_tune),
+        osc_2_fine_tune(initial_state.osc_2_fine_tune),
+        glide_time(initial_state.glide_time),
+        osc_1_unison_voices(initial_state.osc_1_unison_voices),
+        osc_2_unison_voices(initial_state.osc_2_unison_voices),
+        osc_1_unison_detune(initial_state.osc_1_unison_detune),
+        osc_2_unison_detune(initial_state.osc_2_unison_detune),
+        osc_1_unison_spread(initial_state.osc_1_unison_spread),
+        osc_2_unison_spread(initial_state.osc_2_unison_spread),
+        fm_index(initial_state.fm_index),
+        wavetable_position(initial_state.wavetable_position),
         amp_attack(initial_state.amp_attack),
         amp_decay(initial_state.amp_decay),
         amp_sustain(initial_state.amp_sustain),
         amp_release(initial_state.amp_release),
+        amp_pan(initial_state.amp_pan),
         filter_cutoff(initial_state.filter_cutoff),
         filter_q(initial_state.filter_q),
-        num_of_voices(initial_state.num_of_voices)
+        filter_mode(initial_state.filter_mode),
+        filter_key_tracking(initial_state.filter_key_tracking),
+        filter_velocity(initial_state.filter_velocity),
+        num_of_voices(initial_state.num_of_voices),
+        num_of_render_threads(initial_state.num_of_render_threads),
+        realtime_oversampling(initial_state.realtime_oversampling),
+        offline_oversampling(initial_state.offline_oversampling),
+        voice_steal_policy(initial_state.voice_steal_policy),
+        voice_render_mode(initial_state.voice_render_mode),
+        grain_density(initial_state.grain_density),
+        grain_size(initial_state.grain_size),
+        grain_position(initial_state.grain_position),
+        grain_jitter(initial_state.grain_jitter),
+        grain_pitch(initial_state.grain_pitch),
+        grain_pan(initial_state.grain_pan),
+        grain_pan_spread(initial_state.grain_pan_spread),
+        grain_level(initial_state.grain_level),
+        grain_taper(initial_state.grain_taper),
+        grain_window(initial_state.grain_window),
+        grain_interpolation(initial_state.grain_interpolation)
     {}
     ~SynthesizerState()
     {
@@ -104,12 +273,32 @@ public:
         getTransposeHandlers(SynthOSC::SECOND_OSC).clear();
         getWaveTypeHandlers(SynthOSC::FIRST_OSC).clear();
         getWaveTypeHandlers(SynthOSC::SECOND_OSC).clear();
+        wave_crossfade_handlers.clear();
+        pulse_width_handlers.clear();
+        oscillator_mode_handlers.clear();
+        getFineTuneHandlers(SynthOSC::FIRST_OSC).clear();
+        getFineTuneHandlers(SynthOSC::SECOND_OSC).clear();
+        glide_time_handlers.clear();
+        unison_voices_listeners.clear();
+        unison_detune_listeners.clear();
+        unison_spread_listeners.clear();
+        fm_index_handlers.clear();
+        wavetable_position_handlers.clear();
         getAmpADSRHandlers(ADSRStages::ATTACK).clear();
         getAmpADSRHandlers(ADSRStages::DECAY).clear();
         getAmpADSRHandlers(ADSRStages::SUSTAIN).clear();
         getAmpADSRHandlers(ADSRStages::RELEASE).clear();
+        amp_pan_handlers.clear();
         filter_cutoff_handlers.clear();
         filter_q_handlers.clear();
+        filter_mode_handlers.clear();
+        filter_key_tracking_handlers.clear();
+        filter_velocity_handlers.clear();
+        voice_steal_policy_handlers.clear();
+        voice_render_mode_handlers.clear();
+        grain_listeners.clear();
+        grain_window_handlers.clear();
+        grain_interpolation_handlers.clear();
     }
     
     //==============================================================================
@@ -134,7 +323,7 @@ public:
                 osc_2_transpose = transpose;
                 break;
         }
-        for (auto handler : getTransposeHandlers(osc_name))
+        for (const auto& handler : getTransposeHandlers(osc_name))
         {
             try {
                 handler(transpose);
@@ -194,7 +383,7 @@ public:
                 osc_2_wave_type = wave_type;
                 break;
         }
-        for (auto handler : getWaveTypeHandlers(osc_name))
+        for (const auto& handler : getWaveTypeHandlers(osc_name))
         {
             try {
                 handler(wave_type);
@@ -227,12 +416,303 @@ public:
             )
         {
             return VoiceWaveType::SAW;
+        } else if (
+            value == "Square" |
+            value == "square"
+            )
+        {
+            return VoiceWaveType::SQUARE;
+        } else if (
+            value == "Triangle" |
+            value == "triangle"
+            )
+        {
+            return VoiceWaveType::TRIANGLE;
+        } else if (
+            value == "User" |
+            value == "user"
+            )
+        {
+            return VoiceWaveType::USER;
         } else
         {
             return VoiceWaveType::SIN;
         }
     }
     
+    //==============================================================================
+    // milliseconds sounding notes take to fade into a new waveform, 0 switches at once
+    float getWaveCrossfade()
+    {
+        return wave_crossfade;
+    }
+    void setWaveCrossfade(float milliseconds)
+    {
+        if (wave_crossfade == milliseconds) return; // no-change
+        wave_crossfade = milliseconds;
+        for (const auto& handler : wave_crossfade_handlers)
+        {
+            try
+            {
+                handler(milliseconds);
+            } catch (...) {}
+        }
+    }
+    void onWaveCrossfadeChange(CrossfadeHandler handler)
+    {
+        wave_crossfade_handlers.push_back(handler);
+    }
+    
+    //==============================================================================
+    // fraction of the cycle a square spends high, 0.5 is symmetric
+    float getPulseWidth()
+    {
+        return pulse_width;
+    }
+    void setPulseWidth(float width)
+    {
+        if (pulse_width == width) return; // no-change
+        pulse_width = width;
+        for (const auto& handler : pulse_width_handlers)
+        {
+            try
+            {
+                handler(width);
+            } catch (...) {}
+        }
+    }
+    void onPulseWidthChange(PulseWidthHandler handler)
+    {
+        pulse_width_handlers.push_back(handler);
+    }
+    
+    //==============================================================================
+    OscillatorMode getOscillatorMode()
+    {
+        return oscillator_mode;
+    }
+    void setOscillatorMode(OscillatorMode mode)
+    {
+        if (oscillator_mode == mode) return; // no-change
+        oscillator_mode = mode;
+        for (const auto& handler : oscillator_mode_handlers)
+        {
+            try
+            {
+                handler(mode);
+            } catch (...) {}
+        }
+    }
+    void onOscillatorModeChange(OscModeHandler handler)
+    {
+        oscillator_mode_handlers.push_back(handler);
+    }
+    
+    //==============================================================================
+    // in cents, on top of the transpose
+    float getFineTune(SynthOSC osc_name)
+    {
+        switch (osc_name)
+        {
+            case (SynthOSC::FIRST_OSC)  : return osc_1_fine_tune;
+            case (SynthOSC::SECOND_OSC) : return osc_2_fine_tune;
+        }
+    }
+    void setFineTune(SynthOSC osc_name, float cents)
+    {
+        switch(osc_name)
+        {
+            case(SynthOSC::FIRST_OSC):
+                if (cents == osc_1_fine_tune) { return; } // no change
+                osc_1_fine_tune = cents;
+                break;
+            case(SynthOSC::SECOND_OSC):
+                if (cents == osc_2_fine_tune) { return; } // no change
+                osc_2_fine_tune = cents;
+                break;
+        }
+        for (const auto& handler : getFineTuneHandlers(osc_name))
+        {
+            try {
+                handler(cents);
+            } catch (...) {}
+        }
+    }
+    void onFineTuneChange(SynthOSC osc_name, FineTuneHandler handler)
+    {
+        getFineTuneHandlers(osc_name).push_back(handler);
+    }
+    
+    //==============================================================================
+    // milliseconds a new note takes to slide from the previous one's pitch, 0 is off
+    float getGlideTime()
+    {
+        return glide_time;
+    }
+    void setGlideTime(float milliseconds)
+    {
+        if (glide_time == milliseconds) return; // no-change
+        glide_time = milliseconds;
+        for (const auto& handler : glide_time_handlers)
+        {
+            try
+            {
+                handler(milliseconds);
+            } catch (...) {}
+        }
+    }
+    void onGlideTimeChange(GlideHandler handler)
+    {
+        glide_time_handlers.push_back(handler);
+    }
+    
+    //==============================================================================
+    // detuned copies of the oscillator every note plays, 1 is off
+    int getUnisonVoices(SynthOSC osc_name)
+    {
+        switch (osc_name)
+        {
+            case (SynthOSC::FIRST_OSC)  : return osc_1_unison_voices;
+            case (SynthOSC::SECOND_OSC) : return osc_2_unison_voices;
+        }
+    }
+    void setUnisonVoices(SynthOSC osc_name, int value)
+    {
+        switch(osc_name)
+        {
+            case(SynthOSC::FIRST_OSC):
+                if (value == osc_1_unison_voices) { return; } // no change
+                osc_1_unison_voices = value;
+                break;
+            case(SynthOSC::SECOND_OSC):
+                if (value == osc_2_unison_voices) { return; } // no change
+                osc_2_unison_voices = value;
+                break;
+        }
+        for (const auto& handler : getUnisonVoicesHandlers(osc_name))
+        {
+            try {
+                handler(value);
+            } catch (...) {}
+        }
+    }
+    void onUnisonVoicesChange(SynthOSC osc_name, UnisonVoicesHandler handler)
+    {
+        getUnisonVoicesHandlers(osc_name).push_back(handler);
+    }
+    // cents between the middle and the outermost copies
+    float getUnisonDetune(SynthOSC osc_name)
+    {
+        switch (osc_name)
+        {
+            case (SynthOSC::FIRST_OSC)  : return osc_1_unison_detune;
+            case (SynthOSC::SECOND_OSC) : return osc_2_unison_detune;
+        }
+    }
+    void setUnisonDetune(SynthOSC osc_name, float cents)
+    {
+        switch(osc_name)
+        {
+            case(SynthOSC::FIRST_OSC):
+                if (cents == osc_1_unison_detune) { return; } // no change
+                osc_1_unison_detune = cents;
+                break;
+            case(SynthOSC::SECOND_OSC):
+                if (cents == osc_2_unison_detune) { return; } // no change
+                osc_2_unison_detune = cents;
+                break;
+        }
+        for (const auto& handler : getUnisonAmountHandlers(unison_detune_listeners, osc_name))
+        {
+            try {
+                handler(cents);
+            } catch (...) {}
+        }
+    }
+    void onUnisonDetuneChange(SynthOSC osc_name, UnisonAmountHandler handler)
+    {
+        getUnisonAmountHandlers(unison_detune_listeners, osc_name).push_back(handler);
+    }
+    // 0 keeps every copy at the voice pan, 1 spreads the outermost ones a full pan width apart from it
+    float getUnisonSpread(SynthOSC osc_name)
+    {
+        switch (osc_name)
+        {
+            case (SynthOSC::FIRST_OSC)  : return osc_1_unison_spread;
+            case (SynthOSC::SECOND_OSC) : return osc_2_unison_spread;
+        }
+    }
+    void setUnisonSpread(SynthOSC osc_name, float amount)
+    {
+        switch(osc_name)
+        {
+            case(SynthOSC::FIRST_OSC):
+                if (amount == osc_1_unison_spread) { return; } // no change
+                osc_1_unison_spread = amount;
+                break;
+            case(SynthOSC::SECOND_OSC):
+                if (amount == osc_2_unison_spread) { return; } // no change
+                osc_2_unison_spread = amount;
+                break;
+        }
+        for (const auto& handler : getUnisonAmountHandlers(unison_spread_listeners, osc_name))
+        {
+            try {
+                handler(amount);
+            } catch (...) {}
+        }
+    }
+    void onUnisonSpreadChange(SynthOSC osc_name, UnisonAmountHandler handler)
+    {
+        getUnisonAmountHandlers(unison_spread_listeners, osc_name).push_back(handler);
+    }
+    
+    //==============================================================================
+    // peak phase deviation, in radians, OSC #2 drives into OSC #1; 0 mixes them side by side
+    float getFMIndex()
+    {
+        return fm_index;
+    }
+    void setFMIndex(float index)
+    {
+        if (fm_index == index) return; // no-change
+        fm_index = index;
+        for (const auto& handler : fm_index_handlers)
+        {
+            try
+            {
+                handler(index);
+            } catch (...) {}
+        }
+    }
+    void onFMIndexChange(FMIndexHandler handler)
+    {
+        fm_index_handlers.push_back(handler);
+    }
+    
+    //==============================================================================
+    // where the user wavetable is read, 0 is its first frame and 1 its last
+    float getWavetablePosition()
+    {
+        return wavetable_position;
+    }
+    void setWavetablePosition(float position)
+    {
+        if (wavetable_position == position) return; // no-change
+        wavetable_position = position;
+        for (const auto& handler : wavetable_position_handlers)
+        {
+            try
+            {
+                handler(position);
+            } catch (...) {}
+        }
+    }
+    void onWavetablePositionChange(PositionHandler handler)
+    {
+        wavetable_position_handlers.push_back(handler);
+    }
+    
     //==============================================================================
     ADSRParam getAmpADSR(ADSRStages adsr_stage)
     {
@@ -265,7 +745,7 @@ public:
                 amp_release = value;
                 break;
         }
-        for (auto handler : getAmpADSRHandlers(adsr_stage))
+        for (const auto& handler : getAmpADSRHandlers(adsr_stage))
         {
             try
             {
@@ -278,6 +758,28 @@ public:
         getAmpADSRHandlers(adsr_stage).push_back(handler);
     }
     
+    //==============================================================================
+    PanParam getAmpPan()
+    {
+        return amp_pan;
+    }
+    void setAmpPan(PanParam pan)
+    {
+        if (amp_pan == pan) return; // no-change
+        amp_pan = pan;
+        for (const auto& handler : amp_pan_handlers)
+        {
+            try
+            {
+                handler(pan);
+            } catch (...) {}
+        }
+    }
+    void onAmpPanChange(PanHandler handler)
+    {
+        amp_pan_handlers.push_back(handler);
+    }
+    
     //==============================================================================
     Frequency getFilterCutoff()
     {
@@ -287,7 +789,7 @@ public:
     {
         if (filter_cutoff == frequency) return; // no-change
         filter_cutoff = frequency;
-        for (auto handler : filter_cutoff_handlers)
+        for (const auto& handler : filter_cutoff_handlers)
         {
             try
             {
@@ -309,7 +811,7 @@ public:
     {
         if (filter_q == q) return; // no-change
         filter_q = q;
-        for (auto handler : filter_q_handlers)
+        for (const auto& handler : filter_q_handlers)
         {
             try
             {
@@ -322,53 +824,350 @@ public:
         filter_q_handlers.push_back(handler);
     }
     
-private:
-    using TransposeHandlers = std::list<TransposeHandler>;
-    using TransposeListners = std::map<SynthOSC, TransposeHandlers>;
-    VoiceTranspose    osc_1_transpose = VoiceTranspose::NO_TRANSPOSE;
-    VoiceTranspose    osc_2_transpose = VoiceTranspose::NO_TRANSPOSE;
-    TransposeListners transpose_listeners;
-    TransposeHandlers& getTransposeHandlers(SynthOSC osc_name)
+    //==============================================================================
+    FilterMode getFilterMode()
     {
-        if (transpose_listeners.count(osc_name) == 0)
+        return filter_mode;
+    }
+    void setFilterMode(FilterMode mode)
+    {
+        if (filter_mode == mode) return; // no-change
+        filter_mode = mode;
+        for (const auto& handler : filter_mode_handlers)
         {
-            transpose_listeners.insert(TransposeListners::value_type(osc_name, TransposeHandlers()));
+            try
+            {
+                handler(mode);
+            } catch (...) {}
         }
-        return transpose_listeners[osc_name];
+    }
+    void onFilterModeChange(FilterModeHandler handler)
+    {
+        filter_mode_handlers.push_back(handler);
     }
     
     //==============================================================================
-    using WaveTypeHandlers  = std::list<WaveTypeHandler>;
-    using WaveTypeListners  = std::map<SynthOSC, WaveTypeHandlers>;
-    VoiceWaveType    osc_1_wave_type = VoiceWaveType::SIN;
-    VoiceWaveType    osc_2_wave_type = VoiceWaveType::SIN;
-    WaveTypeListners wave_type_listeners;
-    WaveTypeHandlers& getWaveTypeHandlers(SynthOSC osc_name)
+    // per-voice mode only: 1 moves the cutoff an octave per octave played
+    float getFilterKeyTracking()
     {
-        if (wave_type_listeners.count(osc_name) == 0)
+        return filter_key_tracking;
+    }
+    void setFilterKeyTracking(float amount)
+    {
+        if (filter_key_tracking == amount) return; // no-change
+        filter_key_tracking = amount;
+        for (const auto& handler : filter_key_tracking_handlers)
         {
-            wave_type_listeners.insert(WaveTypeListners::value_type(osc_name, WaveTypeHandlers()));
+            try
+            {
+                handler(amount);
+            } catch (...) {}
         }
-        return wave_type_listeners[osc_name];
+    }
+    void onFilterKeyTrackingChange(FilterAmountHandler handler)
+    {
+        filter_key_tracking_handlers.push_back(handler);
     }
     
     //==============================================================================
-    using ADSRHandlers    = std::list<ADSRHandler>;
-    using AmpADSRListners = std::map<ADSRStages, ADSRHandlers>;
-    ADSRParam       amp_attack  = 0.1f;
-    ADSRParam       amp_decay   = 0.1f;
-    ADSRParam       amp_sustain = 1.0f;
-    ADSRParam       amp_release = 1.0f;
-    AmpADSRListners ampADSRListeners;
-    ADSRHandlers& getAmpADSRHandlers(ADSRStages adsr_stage)
+    // per-voice mode only: how far soft notes close the filter
+    float getFilterVelocity()
     {
-        if (ampADSRListeners.count(adsr_stage) == 0)
+        return filter_velocity;
+    }
+    void setFilterVelocity(float amount)
+    {
+        if (filter_velocity == amount) return; // no-change
+        filter_velocity = amount;
+        for (const auto& handler : filter_velocity_handlers)
+        {
+            try
+            {
+                handler(amount);
+            } catch (...) {}
+        }
+    }
+    void onFilterVelocityChange(FilterAmountHandler handler)
+    {
+        filter_velocity_handlers.push_back(handler);
+    }
+    
+    //==============================================================================
+    unsigned int getNumOfVoices()
+    {
+        return num_of_voices;
+    }
+    void setNumOfVoices(unsigned int value)
+    {
+        num_of_voices = value; // picked up by the voice managers off the audio thread
+    }
+    
+    //==============================================================================
+    unsigned int getNumOfRenderThreads()
+    {
+        return num_of_render_threads;
+    }
+    void setNumOfRenderThreads(unsigned int value)
+    {
+        num_of_render_threads = value; // same as above, 1 renders on the audio thread only
+    }
+    
+    //==============================================================================
+    // as powers of two: 0 renders at the host rate, 3 at eight times it
+    unsigned int getRealtimeOversampling()
+    {
+        return realtime_oversampling;
+    }
+    void setRealtimeOversampling(unsigned int value)
+    {
+        realtime_oversampling = value; // applied by the processor when it prepares
+    }
+    unsigned int getOfflineOversampling()
+    {
+        return offline_oversampling;
+    }
+    void setOfflineOversampling(unsigned int value)
+    {
+        offline_oversampling = value; // same as above, used while the host renders offline
+    }
+    
+    //==============================================================================
+    VoiceStealPolicy getVoiceStealPolicy()
+    {
+        return voice_steal_policy;
+    }
+    void setVoiceStealPolicy(VoiceStealPolicy policy)
+    {
+        if (voice_steal_policy == policy) return; // no-change
+        voice_steal_policy = policy;
+        for (const auto& handler : voice_steal_policy_handlers)
+        {
+            try
+            {
+                handler(policy);
+            } catch (...) {}
+        }
+    }
+    void onVoiceStealPolicyChange(StealPolicyHandler handler)
+    {
+        voice_steal_policy_handlers.push_back(handler);
+    }
+    
+    //==============================================================================
+    VoiceRenderMode getVoiceRenderMode()
+    {
+        return voice_render_mode;
+    }
+    void setVoiceRenderMode(VoiceRenderMode mode)
+    {
+        if (voice_render_mode == mode) return; // no-change
+        voice_render_mode = mode;
+        for (const auto& handler : voice_render_mode_handlers)
+        {
+            try
+            {
+                handler(mode);
+            } catch (...) {}
+        }
+    }
+    void onVoiceRenderModeChange(RenderModeHandler handler)
+    {
+        voice_render_mode_handlers.push_back(handler);
+    }
+    
+    //==============================================================================
+    float getGrainParam(GrainParam param)
+    {
+        return getGrainParamValue(param);
+    }
+    void setGrainParam(GrainParam param, float value)
+    {
+        auto& current = getGrainParamValue(param);
+        if (value == current) return; // no-change
+        current = value;
+        for (const auto& handler : getGrainHandlers(param))
+        {
+            try
+            {
+                handler(value);
+            } catch(...) {}
+        }
+    }
+    void onGrainParamChange(GrainParam param, GrainHandler handler)
+    {
+        getGrainHandlers(param).push_back(handler);
+    }
+    
+    //==============================================================================
+    GrainWindowShape getGrainWindow()
+    {
+        return grain_window;
+    }
+    void setGrainWindow(GrainWindowShape shape)
+    {
+        if (grain_window == shape) return; // no-change
+        grain_window = shape;
+        for (const auto& handler : grain_window_handlers)
+        {
+            try
+            {
+                handler(shape);
+            } catch (...) {}
+        }
+    }
+    void onGrainWindowChange(GrainWindowHandler handler)
+    {
+        grain_window_handlers.push_back(handler);
+    }
+    
+    //==============================================================================
+    GrainInterpolation getGrainInterpolation()
+    {
+        return grain_interpolation;
+    }
+    void setGrainInterpolation(GrainInterpolation interpolation)
+    {
+        if (grain_interpolation == interpolation) return; // no-change
+        grain_interpolation = interpolation;
+        for (const auto& handler : grain_interpolation_handlers)
+        {
+            try
+            {
+                handler(interpolation);
+            } catch (...) {}
+        }
+    }
+    void onGrainInterpolationChange(InterpolationHandler handler)
+    {
+        grain_interpolation_handlers.push_back(handler);
+    }
+    
+private:
+    using TransposeHandlers = std::list<TransposeHandler>;
+    using TransposeListners = std::map<SynthOSC, TransposeHandlers>;
+    VoiceTranspose    osc_1_transpose = VoiceTranspose::NO_TRANSPOSE;
+    VoiceTranspose    osc_2_transpose = VoiceTranspose::NO_TRANSPOSE;
+    TransposeListners transpose_listeners;
+    TransposeHandlers& getTransposeHandlers(SynthOSC osc_name)
+    {
+        if (transpose_listeners.count(osc_name) == 0)
+        {
+            transpose_listeners.insert(TransposeListners::value_type(osc_name, TransposeHandlers()));
+        }
+        return transpose_listeners[osc_name];
+    }
+    
+    //==============================================================================
+    using WaveTypeHandlers  = std::list<WaveTypeHandler>;
+    using WaveTypeListners  = std::map<SynthOSC, WaveTypeHandlers>;
+    VoiceWaveType    osc_1_wave_type = VoiceWaveType::SIN;
+    VoiceWaveType    osc_2_wave_type = VoiceWaveType::SIN;
+    WaveTypeListners wave_type_listeners;
+    WaveTypeHandlers& getWaveTypeHandlers(SynthOSC osc_name)
+    {
+        if (wave_type_listeners.count(osc_name) == 0)
+        {
+            wave_type_listeners.insert(WaveTypeListners::value_type(osc_name, WaveTypeHandlers()));
+        }
+        return wave_type_listeners[osc_name];
+    }
+    
+    //==============================================================================
+    using CrossfadeHandlers = std::list<CrossfadeHandler>;
+    float             wave_crossfade = 5.0f;
+    CrossfadeHandlers wave_crossfade_handlers;
+    
+    //==============================================================================
+    using PulseWidthHandlers = std::list<PulseWidthHandler>;
+    using OscModeHandlers    = std::list<OscModeHandler>;
+    float              pulse_width     = 0.5f;
+    OscillatorMode     oscillator_mode = OscillatorMode::WAVETABLE_OSC;
+    PulseWidthHandlers pulse_width_handlers;
+    OscModeHandlers    oscillator_mode_handlers;
+    
+    //==============================================================================
+    using FineTuneHandlers = std::list<FineTuneHandler>;
+    using FineTuneListners = std::map<SynthOSC, FineTuneHandlers>;
+    float            osc_1_fine_tune = 0.0f;
+    float            osc_2_fine_tune = 0.0f;
+    FineTuneListners fine_tune_listeners;
+    FineTuneHandlers& getFineTuneHandlers(SynthOSC osc_name)
+    {
+        if (fine_tune_listeners.count(osc_name) == 0)
+        {
+            fine_tune_listeners.insert(FineTuneListners::value_type(osc_name, FineTuneHandlers()));
+        }
+        return fine_tune_listeners[osc_name];
+    }
+    
+    //==============================================================================
+    using GlideHandlers = std::list<GlideHandler>;
+    float         glide_time = 0.0f;
+    GlideHandlers glide_time_handlers;
+    
+    //==============================================================================
+    using UnisonVoicesHandlers  = std::list<UnisonVoicesHandler>;
+    using UnisonAmountHandlers  = std::list<UnisonAmountHandler>;
+    using UnisonVoicesListeners = std::map<SynthOSC, UnisonVoicesHandlers>;
+    using UnisonAmountListeners = std::map<SynthOSC, UnisonAmountHandlers>;
+    int                   osc_1_unison_voices = 1;
+    int                   osc_2_unison_voices = 1;
+    float                 osc_1_unison_detune = 20.0f;
+    float                 osc_2_unison_detune = 20.0f;
+    float                 osc_1_unison_spread = 0.5f;
+    float                 osc_2_unison_spread = 0.5f;
+    UnisonVoicesListeners unison_voices_listeners;
+    UnisonAmountListeners unison_detune_listeners;
+    UnisonAmountListeners unison_spread_listeners;
+    UnisonVoicesHandlers& getUnisonVoicesHandlers(SynthOSC osc_name)
+    {
+        if (unison_voices_listeners.count(osc_name) == 0)
+        {
+            unison_voices_listeners.insert(UnisonVoicesListeners::value_type(osc_name, UnisonVoicesHandlers()));
+        }
+        return unison_voices_listeners[osc_name];
+    }
+    static UnisonAmountHandlers& getUnisonAmountHandlers(UnisonAmountListeners& listeners, SynthOSC osc_name)
+    {
+        if (listeners.count(osc_name) == 0)
+        {
+            listeners.insert(UnisonAmountListeners::value_type(osc_name, UnisonAmountHandlers()));
+        }
+        return listeners[osc_name];
+    }
+    
+    //==============================================================================
+    using FMIndexHandlers = std::list<FMIndexHandler>;
+    float           fm_index = 0.0f;
+    FMIndexHandlers fm_index_handlers;
+    
+    //==============================================================================
+    using PositionHandlers = std::list<PositionHandler>;
+    float            wavetable_position = 0.0f;
+    PositionHandlers wavetable_position_handlers;
+    
+    //==============================================================================
+    using ADSRHandlers    = std::list<ADSRHandler>;
+    using AmpADSRListners = std::map<ADSRStages, ADSRHandlers>;
+    ADSRParam       amp_attack  = 0.1f;
+    ADSRParam       amp_decay   = 0.1f;
+    ADSRParam       amp_sustain = 1.0f;
+    ADSRParam       amp_release = 1.0f;
+    AmpADSRListners ampADSRListeners;
+    ADSRHandlers& getAmpADSRHandlers(ADSRStages adsr_stage)
+    {
+        if (ampADSRListeners.count(adsr_stage) == 0)
         {
             ampADSRListeners.insert(AmpADSRListners::value_type(adsr_stage, ADSRHandlers()));
         }
         return ampADSRListeners[adsr_stage];
     }
     
+    //==============================================================================
+    using PanHandlers = std::list<PanHandler>;
+    PanParam    amp_pan = 0.0f; // -1 is hard left, 1 hard right
+    PanHandlers amp_pan_handlers;
+    
     //==============================================================================
     using FilterCutoffHandlers = std::list<FilterCutoffhandler>;
     Frequency            filter_cutoff = 1000.0f;
@@ -379,8 +1178,112 @@ private:
     QFactor         filter_q = 1.0f;
     FilterQHandlers filter_q_handlers;
     
+    //==============================================================================
+    using FilterModeHandlers   = std::list<FilterModeHandler>;
+    using FilterAmountHandlers = std::list<FilterAmountHandler>;
+    FilterMode           filter_mode         = FilterMode::GLOBAL_FILTER;
+    float                filter_key_tracking = 0.0f;
+    float                filter_velocity     = 0.0f;
+    FilterModeHandlers   filter_mode_handlers;
+    FilterAmountHandlers filter_key_tracking_handlers;
+    FilterAmountHandlers filter_velocity_handlers;
+    
     //==============================================================================
     unsigned int   num_of_voices   = 4;
+    unsigned int   num_of_render_threads = 1;
+    unsigned int   realtime_oversampling = 0;
+    unsigned int   offline_oversampling  = 0;
+    
+    //==============================================================================
+    using StealPolicyHandlers = std::list<StealPolicyHandler>;
+    VoiceStealPolicy    voice_steal_policy = VoiceStealPolicy::OLDEST;
+    StealPolicyHandlers voice_steal_policy_handlers;
+    
+    //==============================================================================
+    using RenderModeHandlers = std::list<RenderModeHandler>;
+    VoiceRenderMode    voice_render_mode = VoiceRenderMode::SIMD_BANK;
+    RenderModeHandlers voice_render_mode_handlers;
+    
+    //==============================================================================
+    using GrainHandlers = std::list<GrainHandler>;
+    using GrainListners = std::map<GrainParam, GrainHandlers>;
+    float         grain_density    = 0.0f;
+    float         grain_size       = 80.0f;
+    float         grain_position   = 0.0f;
+    float         grain_jitter     = 0.0f;
+    float         grain_pitch      = 0.0f;
+    float         grain_pan        = 0.0f;
+    float         grain_pan_spread = 0.0f;
+    float         grain_level      = 0.5f;
+    float         grain_taper      = 0.5f;
+    GrainListners grain_listeners;
+    float& getGrainParamValue(GrainParam param)
+    {
+        switch(param)
+        {
+            case (GrainParam::GRAIN_DENSITY)    : return grain_density;
+            case (GrainParam::GRAIN_SIZE)       : return grain_size;
+            case (GrainParam::GRAIN_POSITION)   : return grain_position;
+            case (GrainParam::GRAIN_JITTER)     : return grain_jitter;
+            case (GrainParam::GRAIN_PITCH)      : return grain_pitch;
+            case (GrainParam::GRAIN_PAN)        : return grain_pan;
+            case (GrainParam::GRAIN_PAN_SPREAD) : return grain_pan_spread;
+            case (GrainParam::GRAIN_LEVEL)      : return grain_level;
+            case (GrainParam::GRAIN_TAPER)      : break;
+        }
+        return grain_taper;
+    }
+    GrainHandlers& getGrainHandlers(GrainParam param)
+    {
+        if (grain_listeners.count(param) == 0)
+        {
+            grain_listeners.insert(GrainListners::value_type(param, GrainHandlers()));
+        }
+        return grain_listeners[param];
+    }
+    
+    //==============================================================================
+    using GrainWindowHandlers = std::list<GrainWindowHandler>;
+    GrainWindowShape    grain_window = GrainWindowShape::HANN_WINDOW;
+    GrainWindowHandlers grain_window_handlers;
+    
+    //==============================================================================
+    using InterpolationHandlers = std::list<InterpolationHandler>;
+    GrainInterpolation    grain_interpolation = GrainInterpolation::HERMITE_INTERPOLATION;
+    InterpolationHandlers grain_interpolation_handlers;
+};
+
+//==============================================================================
+/** Debug-build guard for the realtime thread: asserts on destruction if anything
+    called new/delete on this thread while it was alive. Needs
+    JUCE_ENABLE_ALLOCATION_HOOKS, which the Debug configurations define.
+*/
+class RealtimeAllocationTripwire
+{
+public:
+   #if JUCE_DEBUG && JUCE_ENABLE_ALLOCATION_HOOKS
+    RealtimeAllocationTripwire()  { juce::getAllocationHooksForThread().addListener(&_counter); }
+    ~RealtimeAllocationTripwire()
+    {
+        const auto num_allocations = _counter.num_allocations; // read before removing, removal may free
+        juce::getAllocationHooksForThread().removeListener(&_counter);
+        jassert (num_allocations == 0); // something allocated inside processBlock
+    }
+   #else
+    RealtimeAllocationTripwire()  {}
+   #endif
+    
+private:
+   #if JUCE_DEBUG && JUCE_ENABLE_ALLOCATION_HOOKS
+    struct AllocationCounter : public juce::AllocationHooks::Listener
+    {
+        void newOrDeleteCalled() noexcept override { ++num_allocations; }
+        size_t num_allocations = 0;
+    };
+    AllocationCounter _counter;
+   #endif
+    
+    JUCE_DECLARE_NON_COPYABLE (RealtimeAllocationTripwire)
 };
 
 //==============================================================================
@@ -415,13 +1318,25 @@ public:
     virtual void reset () noexcept {};
     
     //==============================================================================
-    static dsp::AudioBlock<BufferData> DuplicateAudioBlock (dsp::AudioBlock<BufferData>& src)
+    static dsp::AudioBlock<BufferData> DuplicateAudioBlock (const dsp::AudioBlock<BufferData>& src, juce::AudioBuffer<BufferData>& scratch)
     {
-        juce::AudioBuffer<BufferData> buffer(src.getNumChannels(), src.getNumSamples()); // init empty buffer with same size
-        dsp::AudioBlock<BufferData> block(buffer); // init audio block from buffer
+        auto block = GetScratchBlock(scratch, src.getNumChannels(), src.getNumSamples()); // view on preallocated buffer
         block.copyFrom(src); // copy src buffer to it
         return block;
     }
+    static dsp::AudioBlock<BufferData> GetScratchBlock (juce::AudioBuffer<BufferData>& scratch, size_t num_channels, size_t num_samples)
+    {
+        // scratch buffers are sized in prepare(), never on the audio thread
+        jassert (static_cast<size_t>(scratch.getNumChannels()) >= num_channels);
+        jassert (static_cast<size_t>(scratch.getNumSamples())  >= num_samples);
+        return dsp::AudioBlock<BufferData>(scratch).getSubsetChannelBlock(0, num_channels).getSubBlock(0, num_samples);
+    }
+    static void PrepareScratchBuffer (juce::AudioBuffer<BufferData>& scratch, const IAudioProcessorConfig& spec)
+    {
+        scratch.setSize(static_cast<int>(spec.juce_spec.numChannels),
+                        static_cast<int>(spec.juce_spec.maximumBlockSize),
+                        false, true, false);
+    }
     SynthStatePtr getSynthState()
     {
         return synthesizer_state_ptr;
@@ -435,38 +1350,68 @@ public:
     //==============================================================================
     virtual void prepare (const juce::dsp::ProcessSpec &spec) noexcept override
     {
-        getADSR().setSampleRate(spec.sampleRate);
+        _sample_rate = spec.sampleRate;
         updateParameters();
     }
     virtual void process (const juce::dsp::ProcessContextReplacing<BufferData> &context) noexcept override
     {
-        for (int channel = 0; channel < context.getOutputBlock().getNumChannels(); ++channel)
+        auto& block = context.getOutputBlock();
+        for (size_t sample = 0; sample < block.getNumSamples(); ++sample)
         {
-            auto* output = context.getOutputBlock().getChannelPointer(channel);
-            for (auto sample = 0; sample < context.getOutputBlock().getNumSamples(); ++sample)
+            const auto level = getNextSample(); // one envelope step per sample, whatever the channel count
+            for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
             {
-                output[sample] = getADSR().getNextSample() * output[sample];
+                block.getChannelPointer(channel)[sample] *= level;
             }
         }
     }
     virtual void reset () noexcept override
     {
-        getADSR().reset();
+        _level     = 0.0f;
+        _is_active = false;
     }
     
     //==============================================================================
     void noteOn ()
     {
-        getADSR().reset();
-        getADSR().noteOn();
+        reset();
+        _is_active = true;
+        if (_attack_rate > 0.0f)
+        {
+            _stage = ADSRStages::ATTACK;
+        } else if (_decay_rate > 0.0f)
+        {
+            _level = 1.0f;
+            _stage = ADSRStages::DECAY;
+        } else
+        {
+            _level = _sustain;
+            _stage = ADSRStages::SUSTAIN;
+        }
     }
     void noteOff ()
     {
-        getADSR().noteOff();
+        if (!_is_active) return;
+        if (_release > 0.0f)
+        {
+            _release_rate = static_cast<float>(_level / (_release * _sample_rate)); // release from wherever we are
+            _stage = ADSRStages::RELEASE;
+        } else
+        {
+            reset();
+        }
     }
     bool isActive ()
     {
-        return (getADSR().isActive());
+        return _is_active;
+    }
+    float getLevel () const noexcept
+    {
+        return _level;
+    }
+    ADSRStages getStage () const noexcept
+    {
+        return _stage;
     }
     void setParameter(ADSRStages stage, float value)
     {
@@ -480,309 +1425,2741 @@ public:
         updateParameters();
     }
     
+    //==============================================================================
+    // Same linear segments as juce::ADSR, but the level and stage stay visible
+    // so the voice manager can rank voices when it has to steal one.
+    float getNextSample () noexcept
+    {
+        if (!_is_active) return 0.0f;
+        switch (_stage)
+        {
+            case (ADSRStages::ATTACK):
+                _level += _attack_rate;
+                if (_level >= 1.0f)
+                {
+                    _level = 1.0f;
+                    _stage = (_decay_rate > 0.0f) ? ADSRStages::DECAY : ADSRStages::SUSTAIN;
+                }
+                break;
+            case (ADSRStages::DECAY):
+                _level -= _decay_rate;
+                if (_level <= _sustain)
+                {
+                    _level = _sustain;
+                    _stage = ADSRStages::SUSTAIN;
+                }
+                break;
+            case (ADSRStages::SUSTAIN):
+                _level = _sustain;
+                break;
+            case (ADSRStages::RELEASE):
+                _level -= _release_rate;
+                if (_level <= 0.0f)
+                {
+                    reset();
+                }
+                break;
+        }
+        return _level;
+    }
+    
 private:
+    friend class VoiceBank;
+    
+    //==============================================================================
+    float      _attack  = 0.1f;
+    float      _decay   = 0.1f;
+    float      _sustain = 1.0f;
+    float      _release = 6.9f;
+    
     //==============================================================================
-    juce::ADSR _juce_adsr;
-    float _attack  = 0.1f;
-    float _decay   = 0.1f;
-    float _sustain = 1.0f;
-    float _release = 6.9f;
+    double     _sample_rate  = 44100.0;
+    float      _attack_rate  = 0.0f;
+    float      _decay_rate   = 0.0f;
+    float      _release_rate = 0.0f;
+    float      _level        = 0.0f;
+    ADSRStages _stage        = ADSRStages::ATTACK;
+    bool       _is_active    = false;
     
     //==============================================================================
-    juce::ADSR& getADSR () noexcept
+    float calculateRate (float distance, float time_in_seconds) const noexcept
     {
-        return _juce_adsr;
+        return time_in_seconds > 0.0f ? static_cast<float>(distance / (time_in_seconds * _sample_rate)) : -1.0f;
     }
     void updateParameters ()
     {
-        const auto current_adsr_parameters = getADSR().getParameters();
-        if (
-            current_adsr_parameters.attack  != _attack |
-            current_adsr_parameters.decay   != _decay |
-            current_adsr_parameters.sustain != _sustain |
-            current_adsr_parameters.release != _release
-            )
+        _attack_rate  = calculateRate(1.0f, _attack);
+        _decay_rate   = calculateRate(1.0f - _sustain, _decay);
+        if (_stage != ADSRStages::RELEASE) // a running release keeps the rate it started with
         {
-            getADSR().setParameters({
-                .attack  = _attack,
-                .decay   = _decay,
-                .sustain = _sustain,
-                .release = _release,
-            });
+            _release_rate = calculateRate(_sustain, _release);
+        }
+        if (!_is_active) return;
+        // a stage set to no time mid-way ends right there, as noteOn() skips it
+        if (_stage == ADSRStages::ATTACK && _attack_rate <= 0.0f)
+        {
+            _level = 1.0f;
+            _stage = ADSRStages::DECAY;
+        }
+        if (_stage == ADSRStages::DECAY && _decay_rate <= 0.0f)
+        {
+            _level = _sustain;
+            _stage = ADSRStages::SUSTAIN;
         }
     }
 };
 
 //==============================================================================
-class Voice : public IAudioProcessor
+/** Doubly linked list threaded through its elements, so moving an element
+    between lists never allocates. T has to expose list_prev and list_next.
+*/
+template <typename T>
+class IntrusiveList
 {
 public:
-    Voice(IAudioProcessor::SynthStatePtr state_ptr): IAudioProcessor(state_ptr)
+    //==============================================================================
+    bool isEmpty () const noexcept { return _head == nullptr; }
+    int  size ()    const noexcept { return _size; }
+    T*   front ()   const noexcept { return _head; }
+    T*   back ()    const noexcept { return _tail; }
+    
+    //==============================================================================
+    void pushBack (T* item) noexcept
     {
-        using namespace std::placeholders;
-        getSynthState()->onAmpADSRChange(ADSRStages::ATTACK,  std::bind(&Voice::onAttackChange,  this, _1));
-        getSynthState()->onAmpADSRChange(ADSRStages::DECAY,   std::bind(&Voice::onDecayChange,   this, _1));
-        getSynthState()->onAmpADSRChange(ADSRStages::SUSTAIN, std::bind(&Voice::onSustainChange, this, _1));
-        getSynthState()->onAmpADSRChange(ADSRStages::RELEASE, std::bind(&Voice::onReleaseChange, this, _1));
-        
-        setFrequency(calculateFrequency(440));
+        jassert (item->list_prev == nullptr && item->list_next == nullptr);
+        item->list_prev = _tail;
+        if (_tail != nullptr) { _tail->list_next = item; } else { _head = item; }
+        _tail = item;
+        ++_size;
+    }
+    void pushFront (T* item) noexcept
+    {
+        jassert (item->list_prev == nullptr && item->list_next == nullptr);
+        item->list_next = _head;
+        if (_head != nullptr) { _head->list_prev = item; } else { _tail = item; }
+        _head = item;
+        ++_size;
+    }
+    void remove (T* item) noexcept
+    {
+        if (item->list_prev != nullptr) { item->list_prev->list_next = item->list_next; } else { _head = item->list_next; }
+        if (item->list_next != nullptr) { item->list_next->list_prev = item->list_prev; } else { _tail = item->list_prev; }
+        item->list_prev = nullptr;
+        item->list_next = nullptr;
+        --_size;
+    }
+    T* popFront () noexcept
+    {
+        auto* item = _head;
+        if (item != nullptr) { remove(item); }
+        return item;
+    }
+    void clear () noexcept
+    {
+        while (popFront() != nullptr) {}
+    }
+    
+    //==============================================================================
+    // the callback may remove the item it is given from this list
+    template <typename Callback>
+    void forEach (Callback&& callback)
+    {
+        for (auto* item = _head; item != nullptr;)
+        {
+            auto* next = item->list_next;
+            callback(item);
+            item = next;
+        }
+    }
+    
+private:
+    T*  _head = nullptr;
+    T*  _tail = nullptr;
+    int _size = 0;
+};
+
+//==============================================================================
+class Voice : public IAudioProcessor
+{
+public:
+    //==============================================================================
+    static constexpr size_t NUM_OF_OSCILLATORS = 2;
+    // Glides move the pitch in exact integer steps at this rate, not every
+    // sample, so the SIMD bank keeps its increments constant over runs.
+    static constexpr int    GLIDE_STEP_LENGTH  = 16;
+    // Wavetable position changes are smoothed at the same control rate, and
+    // take this long to arrive.
+    static constexpr int    POSITION_STEP_LENGTH = GLIDE_STEP_LENGTH;
+    static constexpr double POSITION_SMOOTHING   = 0.02; // seconds
+    // Detuned copies of each oscillator one note can stack, see setUnisonVoices().
+    static constexpr int    MAX_UNISON         = 16;
+    
+    using WaveTypes = std::array<VoiceWaveType, NUM_OF_OSCILLATORS>;
+    using PanGains  = std::array<float, 2>; // left, right
+    
+    // Shared by all voices of a manager; each voice turns it into its own
+    // coefficients when its note starts or the settings change.
+    struct FilterSettings
+    {
+        bool  enabled      = false;
+        float cutoff       = 1000.0f;
+        float q            = 1.0f;
+        float key_tracking = 0.0f; // around middle C
+        float velocity     = 0.0f; // 1 takes a zero velocity note four octaves down
+    };
+    
+    //==============================================================================
+    // One note of the synth: both oscillators, and all their unison copies,
+    // share the amp envelope and gain.
+    // ADSR changes are forwarded by the owning VoiceManager, so voices can be
+    // created and destroyed without leaving handlers behind in the state
+    Voice(IAudioProcessor::SynthStatePtr state_ptr): IAudioProcessor(state_ptr)
+    {
+        setNoteFrequency(440.0f);
         setGain(calculateGain(0.0f));
+        setPan(0.0f);
     };
     
     //==============================================================================
     void prepare (const IAudioProcessorConfig &spec) noexcept
     {
-        _processorChain.prepare(spec.juce_spec);
+        _sample_rate = spec.juce_spec.sampleRate;
+        getADSR().prepare(spec.juce_spec);
+        setNoteFrequency(_note_frequency);
+        updateFilter();
+        _steal_fade_length = juce::jmax(1, juce::roundToInt(spec.juce_spec.sampleRate * 0.005));
     }
+    // Scalar per-voice path, VoiceBank renders the same state in SIMD lanes.
+    // Overwrites the first two channels with the voice, panned left and right.
     void process (const IAudioProcessContext &context) noexcept
     {
-        _processorChain.process(context.juce_context);
+        auto& block = context.juce_context.getOutputBlock();
+        auto* left  = block.getChannelPointer(0);
+        auto* right = block.getChannelPointer(1);
+        for (size_t sample = 0; sample < block.getNumSamples(); ++sample)
+        {
+            auto frame = renderSample();
+            if (_steal_fade_left > 0)
+            {
+                // fade the stolen note out, then start the pending one in the same block
+                const auto fade = static_cast<float>(--_steal_fade_left) / static_cast<float>(_steal_fade_length);
+                frame[0] *= fade;
+                frame[1] *= fade;
+                if (_steal_fade_left == 0)
+                {
+                    startNote();
+                }
+            }
+            left[sample]  = frame[0];
+            right[sample] = frame[1];
+        }
+    }
+    void reset () noexcept
+    {
+        getADSR().reset();
+        for (auto& oscillator : _oscillators)
+        {
+            for (auto& copy : oscillator.copies)
+            {
+                copy.phase  = 0;
+                copy.filter = {};
+            }
+            oscillator.fade_left = 0;
+        }
+        _glide_steps_left = 0;
+        _steal_fade_left  = 0;
+        _is_held         = false;
+        _current_note    = -1;
+    }
+    
+    //==============================================================================
+    // glide_from_note is the note to slide from, -1 starts at the note's own pitch.
+    void noteOn (int note_number, int velocity, int glide_from_note = -1)
+    {
+        setCurrentNote(note_number);
+        _velocity        = velocity;
+        _is_held         = true;
+        _glide_from_note = glide_from_note;
+        startNote();
+    }
+    // Takes over a sounding voice: the old note fades out over a few
+    // milliseconds before the new one starts, instead of being cut. Stolen
+    // again while fading, only the pending note changes, the fade carries on.
+    void steal (int note_number, int velocity, int glide_from_note = -1)
+    {
+        setCurrentNote(note_number);
+        _velocity        = velocity;
+        _is_held         = true;
+        _glide_from_note = glide_from_note;
+        if (_steal_fade_left == 0)
+        {
+            _steal_fade_left = _steal_fade_length;
+        }
+    }
+    void noteOff ()
+    {
+        _is_held = false;
+        if (_steal_fade_left == 0) // a pending note is released as soon as it starts
+        {
+            getADSR().noteOff();
+        }
+    }
+    
+    //==============================================================================
+    // Only swaps table pointers, the tables are built up front. A sounding voice
+    // can fade from the old waveform into the new one over fade_length samples.
+    void setWaveType(SynthOSC osc, VoiceWaveType wave_type, int fade_length = 0)
+    {
+        auto& oscillator = _oscillators[osc];
+        if (fade_length > 0 && isBusy() && wave_type != oscillator.source.wave_type)
+        {
+            oscillator.previous = oscillator.source;
+            oscillator.fade_length = oscillator.fade_left = fade_length;
+        } else
+        {
+            oscillator.fade_left = 0;
+        }
+        oscillator.source.wave_type = wave_type;
+        oscillator.source.mode      = _oscillator_mode;
+        oscillator.source.wavetable = getSharedWavetable(wave_type); // shared, nothing to build here
+        pointAtFrames(oscillator.source);
+        updateTableLevel(oscillator);
+    }
+    // Audio thread, when a new table arrives: moves every source playing the
+    // user wavetable, fading ones included, off the table it replaces.
+    void setUserWavetable(const UserWavetable* table)
+    {
+        _user_wavetable = table;
+        updateFrames();
+    }
+    // 0 plays the first frame of the user wavetable, 1 the last. A sounding
+    // voice moves there in steps, see POSITION_SMOOTHING; one that isn't
+    // jumps.
+    void setWavetablePosition(float position)
+    {
+        _position_target = juce::jlimit(0.0f, 1.0f, position);
+        if (!isBusy())
+        {
+            _position = _position_target;
+            _position_steps_left = 0;
+            updateFrames();
+            return;
+        }
+        if (_position_steps_left == 0)
+        {
+            _position_countdown = POSITION_STEP_LENGTH;
+        }
+        _position_steps_left = juce::jmax(1, juce::roundToInt(_sample_rate * POSITION_SMOOTHING / POSITION_STEP_LENGTH));
+        _position_step       = (_position_target - _position) / static_cast<float>(_position_steps_left);
+    }
+    // Both modes line up in phase and level, switching needs no fade.
+    void setOscillatorMode(OscillatorMode mode)
+    {
+        _oscillator_mode = mode;
+        for (auto& oscillator : _oscillators)
+        {
+            oscillator.source.mode = mode;
+        }
+    }
+    void setPulseWidth(float width)
+    {
+        _pulse_width = juce::jlimit(0.01f, 0.99f, width);
+    }
+    // OSC #2 moves the phase of OSC #1 by up to index radians, both stay in the mix.
+    void setFMIndex(float index)
+    {
+        _fm_depth = juce::jmax(0.0f, index) / juce::MathConstants<float>::twoPi; // in cycles
+    }
+    void setTranspose(SynthOSC osc, VoiceTranspose transpose)
+    {
+        _oscillators[osc].transpose = transpose; // picked up by the next note
+    }
+    // Tuning only retunes a sounding voice, an idle one picks it up as its next note starts.
+    void setFineTune(SynthOSC osc, float cents)
+    {
+        _oscillators[osc].fine_tune = cents;
+        updateSoundingIncrements();
+    }
+    void setPitchBend(float semitones)
+    {
+        _pitch_bend = semitones;
+        updateSoundingIncrements();
+    }
+    void setGlideLength(int num_samples)
+    {
+        _glide_length = num_samples; // used from the next note on
+    }
+    // Copies added to a sounding note carry on from the first copy's pitch, so
+    // they join a glide instead of sliding in from wherever they last were.
+    void setUnisonVoices(SynthOSC osc, int num_of_copies)
+    {
+        auto& oscillator = _oscillators[osc];
+        num_of_copies = juce::jlimit(1, MAX_UNISON, num_of_copies);
+        for (auto copy = oscillator.unison; copy < num_of_copies; ++copy)
+        {
+            oscillator.copies[static_cast<size_t>(copy)].increment = oscillator.copies[0].increment;
+            oscillator.copies[static_cast<size_t>(copy)].filter    = {};
+        }
+        oscillator.unison = num_of_copies;
+        updateIncrements();
+        updateUnisonGains();
+    }
+    void setUnisonDetune(SynthOSC osc, float cents)
+    {
+        _oscillators[osc].unison_detune = cents;
+        updateSoundingIncrements();
+    }
+    void setUnisonSpread(SynthOSC osc, float amount)
+    {
+        _oscillators[osc].unison_spread = amount;
+        updateUnisonGains();
+    }
+    // The most copies either oscillator plays, the lanes the voice fills in VoiceBank.
+    int getNumOfCopies () const noexcept
+    {
+        return juce::jmax(_oscillators[SynthOSC::FIRST_OSC].unison, _oscillators[SynthOSC::SECOND_OSC].unison);
+    }
+    void setNoteFrequency(float note_frequency)
+    {
+        _note_frequency = note_frequency;
+        updateIncrements();
+    }
+    void setGain(float gain)
+    {
+        _gain = gain;
+    }
+    void setPan(float pan)
+    {
+        _pan = pan;
+        updateUnisonGains();
+    }
+    void setFilterSettings(const FilterSettings& settings)
+    {
+        _filter_settings = settings;
+        if (isBusy()) // idle voices pick them up when their next note starts
+        {
+            updateFilter();
+        }
+    }
+    void setADSRParameter(ADSRStages stage, float value)
+    {
+        getADSR().setParameter(stage, value);
+    }
+    
+    //==============================================================================
+    bool isBusy ()
+    {
+        return (getADSR().isActive() || _steal_fade_left > 0);
+    }
+    bool isHeld () const noexcept
+    {
+        return _is_held;
+    }
+    float getLevel ()
+    {
+        return getADSR().getLevel() * _gain;
+    }
+    ADSRStages getEnvelopeStage ()
+    {
+        return getADSR().getStage();
+    }
+    void setCurrentNote (int note_number)
+    {
+        _current_note = note_number;
+    }
+    int getCurrentNote ()
+    {
+        return _current_note;
+    }
+    
+    //==============================================================================
+    // Tables are built once per process, on first use, and shared read-only by
+    // every voice of every plugin instance. A sine has a single partial and
+    // can't alias, it stays computed. The user wavetable is the voice's own,
+    // see setUserWavetable().
+    static const Wavetable* getSharedWavetable (VoiceWaveType wave_type)
+    {
+        switch (wave_type)
+        {
+            case (VoiceWaveType::SIN)  : return nullptr;
+            case (VoiceWaveType::USER) : return nullptr;
+            case (VoiceWaveType::SAW) :
+            case (VoiceWaveType::SQUARE) : // any width from two saws, see generate()
+            {
+                static const Wavetable saw([](int harmonic) { return -2.0 / (juce::MathConstants<double>::pi * harmonic); });
+                return &saw;
+            }
+            case (VoiceWaveType::TRIANGLE) :
+            {
+                static const Wavetable triangle([](int harmonic) {
+                    if (harmonic % 2 == 0) return 0.0;
+                    const auto sign = (harmonic % 4 == 1) ? 1.0 : -1.0;
+                    return sign * 8.0 / (juce::MathConstants<double>::pi * juce::MathConstants<double>::pi * harmonic * harmonic);
+                });
+                return &triangle;
+            }
+        }
+        return nullptr;
+    }
+    // Constant power, scaled so the centre keeps unity gain on both sides.
+    static PanGains calculatePanGains (float pan)
+    {
+        const auto cycles = (juce::jlimit(-1.0f, 1.0f, pan) + 1.0f) * 0.125f; // a quarter turn from left to right
+        return {{ juce::MathConstants<float>::sqrt2 * FastMath::cos2pi(cycles),
+                  juce::MathConstants<float>::sqrt2 * FastMath::sin2pi(cycles) }};
+    }
+
+    //==============================================================================
+    // links for the VoiceManager's active/free lists
+    Voice* list_prev = nullptr;
+    Voice* list_next = nullptr;
+    
+private:
+    friend class VoiceBank;
+    
+    //==============================================================================
+    // Start phase offset between consecutive unison copies, in cycles: the
+    // golden ratio keeps any number of them far apart.
+    static constexpr double UNISON_PHASE_STEP = 0.6180339887498949;
+    
+    //==============================================================================
+    struct Source
+    {
+        VoiceWaveType    wave_type   = VoiceWaveType::SIN;
+        OscillatorMode   mode        = OscillatorMode::WAVETABLE_OSC;
+        const Wavetable* wavetable   = nullptr; // null for the computed sine
+        const float*     table_level = nullptr; // mip level for the current increment
+        const Wavetable* next_wavetable   = nullptr; // user wavetable only: the frame after, blended in
+        const float*     next_table_level = nullptr;
+    };
+    // TPT state variable lowpass, same topology as juce::dsp::StateVariableTPTFilter.
+    // Every unison copy runs its own states through the voice's coefficients.
+    struct Filter
+    {
+        float g  = 0.0f;
+        float rg = 0.0f;
+        float h  = 0.0f;
+    };
+    struct FilterState
+    {
+        float s1 = 0.0f; // integrators
+        float s2 = 0.0f;
+    };
+    // One unison copy of an oscillator, the pitch and phase it plays at.
+    struct Copy
+    {
+        juce::uint32   phase           = 0;    // see FixedPhase
+        juce::uint32   increment       = 0;
+        juce::uint32   glide_step      = 0;    // added every GLIDE_STEP_LENGTH samples, wraps for downward glides
+        juce::uint32   glide_target    = 0;    // increment after the last step
+        float          phase_increment = 0.0f; // the increment in cycles per sample, for kernels and tables
+        FilterState    filter;
+        PanGains       gains {};               // the pan law, shared by 1 / sqrt(unison)
+    };
+    struct Oscillator
+    {
+        Source         source;      // shared by the copies, the mip level suits the highest one
+        Source         previous;    // faded out after a waveform switch
+        int            fade_length = 1;
+        int            fade_left   = 0;
+        VoiceTranspose transpose       = VoiceTranspose::NO_TRANSPOSE;
+        float          fine_tune       = 0.0f; // cents
+        int            unison          = 1;
+        float          unison_detune   = 0.0f; // cents, outermost copies
+        float          unison_spread   = 0.0f;
+        std::array<Copy, MAX_UNISON> copies {}; // the first unison of them play
+    };
+    using Frame = std::array<BufferData, 2>; // left, right
+    
+    //==============================================================================
+    ADSRProcessor  _adsr;
+    std::array<Oscillator, NUM_OF_OSCILLATORS> _oscillators {};
+    FilterSettings _filter_settings;
+    Filter         _filter;
+    double         _sample_rate    = 44100.0;
+    float          _note_frequency = 440.0f;
+    float          _gain           = 0.0f;
+    float          _pan            = 0.0f;
+    OscillatorMode _oscillator_mode = OscillatorMode::WAVETABLE_OSC;
+    float          _pulse_width     = 0.5f;
+    float          _fm_depth        = 0.0f; // phase modulation of OSC #1 by OSC #2, in cycles
+    const UserWavetable* _user_wavetable = nullptr; // owned by the processor, see RealtimeSwap
+    float          _position        = 0.0f; // user wavetable position, 0 to 1
+    float          _position_target = 0.0f;
+    float          _position_step   = 0.0f; // added every POSITION_STEP_LENGTH samples
+    int            _position_steps_left = 0;
+    int            _position_countdown  = 0;
+    float          _frame_blend         = 0.0f; // how far the position is from a frame to the next
+    float          _pitch_bend      = 0.0f; // semitones
+    int            _glide_length     = 0;   // samples, 0 is off
+    int            _glide_from_note  = -1;
+    int            _glide_steps_left = 0;
+    int            _glide_countdown  = 0;   // samples until the next step
+    int            _current_note = -1;
+    int            _velocity     = 0;
+    bool           _is_held      = false;
+    int            _steal_fade_length = 1;
+    int            _steal_fade_left   = 0;
+    
+    //==============================================================================
+    void startNote ()
+    {
+        getADSR().noteOn();
+        for (auto& oscillator : _oscillators)
+        {
+            // both oscillators start in phase on every note; unison copies start
+            // spread apart, the same way on every note, so they don't attack as one
+            for (size_t copy = 0; copy < oscillator.copies.size(); ++copy)
+            {
+                oscillator.copies[copy].phase = FixedPhase::fromCycles(static_cast<double>(copy) * UNISON_PHASE_STEP);
+            }
+        }
+        
+        _glide_steps_left = 0;
+        if (_glide_length > 0 && _glide_from_note >= 0 && _glide_from_note != getCurrentNote())
+        {
+            setNoteFrequency(static_cast<float>(juce::MidiMessage::getMidiNoteInHertz(_glide_from_note)));
+            _glide_steps_left = juce::jmax(1, (_glide_length + GLIDE_STEP_LENGTH - 1) / GLIDE_STEP_LENGTH);
+            _glide_countdown  = GLIDE_STEP_LENGTH;
+        }
+        // the glide target, if gliding, with the bend, fine tune and detune stored while idle
+        setNoteFrequency(static_cast<float>(juce::MidiMessage::getMidiNoteInHertz(getCurrentNote())));
+        setGain(calculateGain(static_cast<float>(_velocity)));
+        for (auto& oscillator : _oscillators)
+        {
+            for (auto& copy : oscillator.copies)
+            {
+                copy.filter = {};
+            }
+        }
+        updateFilter();
+        if (!_is_held)
+        {
+            getADSR().noteOff();
+        }
+    }
+    Frame renderSample () noexcept
+    {
+        // a waveform crossfade moves on once per sample, however many copies play it
+        std::array<float, NUM_OF_OSCILLATORS> previous {};
+        for (size_t osc = 0; osc < NUM_OF_OSCILLATORS; ++osc)
+        {
+            auto& oscillator = _oscillators[osc];
+            if (oscillator.fade_left > 0)
+            {
+                previous[osc] = static_cast<float>(oscillator.fade_left--) / static_cast<float>(oscillator.fade_length);
+            }
+        }
+        const auto level = getADSR().getNextSample();
+        
+        Frame frame {{ 0.0f, 0.0f }};
+        auto& carrier   = _oscillators[SynthOSC::FIRST_OSC];
+        auto& modulator = _oscillators[SynthOSC::SECOND_OSC];
+        const auto envelope = level * _gain;
+        
+        // OSC #2 first, its output bends the phase OSC #1 reads at
+        std::array<BufferData, MAX_UNISON> modulation;
+        for (size_t copy = 0; copy < static_cast<size_t>(modulator.unison); ++copy)
+        {
+            auto& state = modulator.copies[copy];
+            modulation[copy] = generate(modulator, state, FixedPhase::toFloat(state.phase), previous[SynthOSC::SECOND_OSC]);
+            state.phase += state.increment; // wraps by itself
+            mixCopy(frame, state, modulation[copy], envelope);
+        }
+        for (size_t copy = 0; copy < static_cast<size_t>(carrier.unison); ++copy)
+        {
+            // with fewer copies of OSC #2, the carriers take turns over them
+            auto& state = carrier.copies[copy];
+            auto phase  = FixedPhase::toFloat(state.phase);
+            if (_fm_depth > 0.0f)
+            {
+                phase = FastMath::wrap(phase + modulation[copy % static_cast<size_t>(modulator.unison)] * _fm_depth);
+            }
+            const auto value = generate(carrier, state, phase, previous[SynthOSC::FIRST_OSC]);
+            state.phase += state.increment;
+            mixCopy(frame, state, value, envelope);
+        }
+        if (_glide_steps_left > 0)
+        {
+            advanceGlide(1);
+        }
+        if (_position_steps_left > 0)
+        {
+            advancePosition(1);
+        }
+        return frame;
+    }
+    void mixCopy (Frame& frame, Copy& copy, BufferData value, float envelope) const noexcept
+    {
+        if (_filter_settings.enabled)
+        {
+            value = filterSample(copy.filter, value);
+        }
+        value = value * envelope;
+        frame[0] += value * copy.gains[0];
+        frame[1] += value * copy.gains[1];
+    }
+    BufferData filterSample (FilterState& state, BufferData input) const noexcept
+    {
+        const auto high = (input - state.s1 * _filter.rg - state.s2) * _filter.h;
+        const auto band = high * _filter.g + state.s1;
+        state.s1        = high * _filter.g + band;
+        const auto low  = band * _filter.g + state.s2;
+        state.s2        = band * _filter.g + low;
+        return low;
+    }
+    // Per note, not per sample: key tracking and velocity cost nothing while rendering.
+    void updateFilter ()
+    {
+        const auto key      = (_current_note >= 0) ? static_cast<float>(_current_note - 60) : 0.0f;
+        const auto velocity = static_cast<float>(_velocity) / 127.0f;
+        const auto octaves  = _filter_settings.key_tracking * key / 12.0f
+                            + _filter_settings.velocity * 4.0f * (velocity - 1.0f);
+        const auto cutoff   = juce::jlimit(20.0f, static_cast<float>(_sample_rate * 0.45),
+                                           _filter_settings.cutoff * FastMath::exp2(octaves));
+        
+        _filter.g  = static_cast<float>(std::tan(juce::MathConstants<double>::pi * cutoff / _sample_rate));
+        _filter.rg = 1.0f / _filter_settings.q + _filter.g;
+        _filter.h  = 1.0f / (1.0f + _filter.g * _filter.rg);
+    }
+    
+    //==============================================================================
+    ADSRProcessor& getADSR () noexcept
+    {
+        return _adsr;
+    }
+
+    // Targets for the current note, bend, fine tune and unison detune; while
+    // gliding, the remaining steps are respread to reach them.
+    void updateIncrements () noexcept
+    {
+        for (auto& oscillator : _oscillators)
+        {
+            const auto frequency = calculateFrequency(oscillator.transpose, _note_frequency);
+            for (int index = 0; index < oscillator.unison; ++index)
+            {
+                auto& copy        = oscillator.copies[static_cast<size_t>(index)];
+                const auto cents  = oscillator.fine_tune + oscillator.unison_detune * getUnisonPosition(oscillator, index);
+                const auto ratio  = FastMath::exp2((cents / 100.0f + _pitch_bend) / 12.0f); // per copy on every bend, libm would add up
+                const auto target = FixedPhase::fromCycles(frequency * ratio / _sample_rate);
+                if (_glide_steps_left > 0)
+                {
+                    const auto distance = static_cast<juce::int64>(target) - static_cast<juce::int64>(copy.increment);
+                    copy.glide_target = target;
+                    copy.glide_step   = static_cast<juce::uint32>(distance / _glide_steps_left);
+                } else
+                {
+                    copy.increment = target;
+                }
+            }
+            updatePhaseIncrements(oscillator);
+        }
+    }
+    void updateSoundingIncrements () noexcept
+    {
+        if (isBusy())
+        {
+            updateIncrements();
+        }
+    }
+    // Copies sit evenly from -1 to 1, a single one in the middle.
+    static float getUnisonPosition (const Oscillator& oscillator, int copy) noexcept
+    {
+        const auto unison = oscillator.unison;
+        return (unison > 1) ? 2.0f * static_cast<float>(copy) / static_cast<float>(unison - 1) - 1.0f : 0.0f;
+    }
+    // Pans the copies around the voice pan, at equal power whatever their number.
+    void updateUnisonGains () noexcept
+    {
+        for (auto& oscillator : _oscillators)
+        {
+            const auto normalise = 1.0f / std::sqrt(static_cast<float>(oscillator.unison));
+            for (int copy = 0; copy < oscillator.unison; ++copy)
+            {
+                auto& gains = oscillator.copies[static_cast<size_t>(copy)].gains;
+                gains = calculatePanGains(_pan + oscillator.unison_spread * getUnisonPosition(oscillator, copy));
+                gains[0] *= normalise;
+                gains[1] *= normalise;
+            }
+        }
+    }
+    // Counts rendered samples towards the next glide step, true if it was taken.
+    bool advanceGlide (int num_samples) noexcept
+    {
+        jassert (num_samples <= _glide_countdown);
+        _glide_countdown -= num_samples;
+        if (_glide_countdown > 0)
+        {
+            return false;
+        }
+        --_glide_steps_left;
+        for (auto& oscillator : _oscillators)
+        {
+            for (size_t index = 0; index < static_cast<size_t>(oscillator.unison); ++index)
+            {
+                auto& copy     = oscillator.copies[index];
+                copy.increment = (_glide_steps_left > 0) ? copy.increment + copy.glide_step : copy.glide_target;
+            }
+            updatePhaseIncrements(oscillator);
+        }
+        _glide_countdown = GLIDE_STEP_LENGTH;
+        return true;
+    }
+    void updatePhaseIncrements (Oscillator& oscillator) const noexcept
+    {
+        for (size_t index = 0; index < static_cast<size_t>(oscillator.unison); ++index)
+        {
+            auto& copy = oscillator.copies[index];
+            copy.phase_increment = static_cast<float>(FixedPhase::toCycles(copy.increment));
+        }
+        updateTableLevel(oscillator);
+    }
+    // One mip level for all copies, picked for the highest so none of them aliases.
+    void updateTableLevel (Oscillator& oscillator) const noexcept
+    {
+        auto highest = 0.0f;
+        for (size_t index = 0; index < static_cast<size_t>(oscillator.unison); ++index)
+        {
+            highest = juce::jmax(highest, oscillator.copies[index].phase_increment);
+        }
+        for (auto* source : { &oscillator.source, &oscillator.previous })
+        {
+            source->table_level      = (source->wavetable      != nullptr) ? source->wavetable->getLevel(highest)      : nullptr;
+            source->next_table_level = (source->next_wavetable != nullptr) ? source->next_wavetable->getLevel(highest) : nullptr;
+        }
+    }
+    // The frames around the position, for every source playing the user wavetable.
+    void updateFrames () noexcept
+    {
+        const auto frame = (_user_wavetable != nullptr) ? _user_wavetable->getFramePosition(_position) : 0.0f;
+        _frame_blend     = frame - std::floor(frame);
+        for (auto& oscillator : _oscillators)
+        {
+            pointAtFrames(oscillator.source);
+            pointAtFrames(oscillator.previous);
+            updateTableLevel(oscillator);
+        }
+    }
+    void pointAtFrames (Source& source) const noexcept
+    {
+        if (source.wave_type != VoiceWaveType::USER)
+        {
+            source.next_wavetable = nullptr;
+            return;
+        }
+        if (_user_wavetable == nullptr)
+        {
+            source.wavetable = source.next_wavetable = nullptr;
+            return;
+        }
+        const auto frame = static_cast<int>(_user_wavetable->getFramePosition(_position));
+        source.wavetable      = _user_wavetable->getFrame(frame);
+        source.next_wavetable = _user_wavetable->getFrame(frame + 1); // the last frame again at the end
+    }
+    // Counts rendered samples towards the next position step, true if it was taken.
+    bool advancePosition (int num_samples) noexcept
+    {
+        jassert (num_samples <= _position_countdown);
+        _position_countdown -= num_samples;
+        if (_position_countdown > 0)
+        {
+            return false;
+        }
+        --_position_steps_left;
+        _position = (_position_steps_left > 0) ? _position + _position_step : _position_target;
+        updateFrames();
+        _position_countdown = POSITION_STEP_LENGTH;
+        return true;
+    }
+    // previous is the weight of the waveform faded out, 0 when not fading.
+    BufferData generate (const Oscillator& oscillator, const Copy& copy, float phase, float previous) const noexcept
+    {
+        auto value = generate(oscillator.source, copy, phase);
+        if (previous > 0.0f) // both waveforms share the phase, so the mix stays coherent
+        {
+            value += previous * (generate(oscillator.previous, copy, phase) - value);
+        }
+        return value;
+    }
+    BufferData generate (const Source& source, const Copy& copy, float phase) const noexcept
+    {
+        if (source.wave_type == VoiceWaveType::SIN)
+        {
+            return genSinWave(phase);
+        }
+        if (source.wave_type == VoiceWaveType::USER) // tables only, in either mode
+        {
+            return (source.table_level != nullptr) ? Wavetable::lookup(source.table_level, source.next_table_level, _frame_blend, phase) : 0.0f;
+        }
+        if (source.mode == OscillatorMode::POLYBLEP_OSC)
+        {
+            switch (source.wave_type)
+            {
+                case (VoiceWaveType::SAW)      : return PolyBLEP::saw(phase, copy.phase_increment);
+                case (VoiceWaveType::SQUARE)   : return PolyBLEP::pulse(phase, copy.phase_increment, _pulse_width);
+                case (VoiceWaveType::TRIANGLE) : return PolyBLEP::triangle(phase, copy.phase_increment);
+                default                        : return 0.0f;
+            }
+        }
+        switch (source.wave_type)
+        {
+            case (VoiceWaveType::SQUARE) :
+            {
+                // the difference of two saws, shifted by the width, is a band-limited pulse without DC
+                auto shifted = phase - _pulse_width + 1.0f;
+                if (shifted >= 1.0f) { shifted -= 1.0f; }
+                return Wavetable::lookup(source.table_level, shifted) - Wavetable::lookup(source.table_level, phase);
+            }
+            default : return Wavetable::lookup(source.table_level, phase);
+        }
+    }
+    BufferData static genSinWave (BufferData phase)
+    {
+        return FastMath::sin2pi(phase); // same polynomial as the bank's lanes
+    }
+    
+    //==============================================================================
+    static double calculateFrequency (VoiceTranspose transpose, double note_freq)
+    {
+        switch (transpose)
+        {
+            case VoiceTranspose::MINUS_TWO_OCTAVES : return note_freq / 4;
+            case VoiceTranspose::MINUS_ONE_OCTAVE  : return note_freq / 2;
+            case VoiceTranspose::NO_TRANSPOSE      : return note_freq;
+            case VoiceTranspose::PLUS_ONE_OCTAVE   : return note_freq * 2;
+            case VoiceTranspose::PLUS_TWO_OCTAVES  : return note_freq * 4;
+        }
+        return note_freq;
+    }
+    float calculateGain (float velocity)
+    {
+        return velocity / 127.0f * 0.05f;
+    }
+};
+
+//==============================================================================
+/** Renders groups of voices side by side, one unison copy of a voice per SIMD
+    lane: lane i of a voice plays copy i of either oscillator. When OSC #2 has
+    fewer copies than OSC #1, its copies repeat over the remaining lanes, silent
+    there, so every copy of OSC #1 still has a modulator in its own lane.
+
+    Table-based waveforms are read per lane from the mip level each voice
+    picked for its pitch; the tables themselves are shared, see Wavetable.
+    PolyBLEP waveforms are computed on all lanes at once, see PolyBLEP.
+    With an FM index, OSC #2 is computed first in the same loop and its output
+    bends the phase OSC #1 reads at, so modulation costs no extra pass.
+    While a waveform switch crossfades the manager renders per voice, so
+    every oscillator here plays a single waveform.
+
+    At the start of every block the state of the active voices is loaded into
+    contiguous, aligned structure-of-arrays storage (the phases and phase
+    increments of both oscillators, envelope levels, per-side gains of each
+    oscillator and, in per-voice filter mode, the filter coefficients and each
+    oscillator's filter states), rendered into a
+    left/right mix pair, and written back. Both this path and
+    the scalar Voice::process read and advance the same state, so either can
+    take over at any block boundary.
+
+    A voice takes lanesPerVoice() lanes: the copies of the oscillator with the
+    most of them, padded with silent lanes
+    to a power of two that divides the register, or to whole registers when
+    they fill more than one. Small stacks then share registers between voices
+    and big ones fill theirs, so a stack costs about its number of registers,
+    not its number of copies. A group is the lanes of as many voices as fill
+    at least one register; its copies repeat the voice's envelope, so every
+    lane stays in step with the one ADSR of the note.
+
+    Phases are advanced in the split fixed-point form of FixedPhase, bit-exact
+    with the scalar path. Envelope segments are linear and glides step at a
+    fixed rate, so a group is rendered in runs between the samples where some
+    lane changes envelope stage, takes a glide step or finishes a steal fade;
+    those transitions are handled per lane, the runs are pure SIMD.
+*/
+class VoiceBank
+{
+public:
+    //==============================================================================
+    using Lanes    = juce::dsp::SIMDRegister<BufferData>;
+    using IntLanes = FixedPhase::IntLanes;
+    using Mix      = std::array<BufferData*, 2>; // left, right
+    
+    //==============================================================================
+    static size_t lanesPerVoice (int unison) noexcept
+    {
+        const auto num_lanes = Lanes::size();
+        const auto copies    = static_cast<size_t>(juce::jmax(1, unison));
+        if (copies > num_lanes)
+        {
+            return (copies + num_lanes - 1) / num_lanes * num_lanes;
+        }
+        size_t lanes = 1;
+        while (lanes < copies)
+        {
+            lanes *= 2;
+        }
+        return lanes;
+    }
+    
+    //==============================================================================
+    // Allocates, call it off the audio thread.
+    void prepare (size_t max_num_of_voices)
+    {
+        const auto num_lanes = Lanes::size();
+        _capacity = (max_num_of_voices * lanesPerVoice(Voice::MAX_UNISON) + num_lanes - 1) / num_lanes * num_lanes;
+        
+        _storage.allocate(NUM_ARRAYS * _capacity + num_lanes, true); // one spare group to align the start
+        _int_storage.allocate(NUM_INT_ARRAYS * _capacity + num_lanes, true);
+        for (auto* levels : { &_table_level, &_next_table_level })
+        {
+            for (auto& oscillator_levels : *levels)
+            {
+                oscillator_levels.allocate(_capacity, true);
+            }
+        }
+        auto* aligned_int = IntLanes::getNextSIMDAlignedPtr(_int_storage.get());
+        for (auto* array : { &_phase_coarse[0], &_phase_coarse[1], &_phase_fine[0], &_phase_fine[1],
+                             &_step_coarse[0], &_step_coarse[1], &_step_fine[0], &_step_fine[1] })
+        {
+            *array       = aligned_int;
+            aligned_int += _capacity;
+        }
+        auto* aligned = Lanes::getNextSIMDAlignedPtr(_storage.get());
+        for (auto* array : { &_increment[0], &_increment[1], &_inv_increment[0], &_inv_increment[1], &_pulse_width, &_fm_depth, &_frame_blend,
+                             &_gain_left[0], &_gain_left[1], &_gain_right[0], &_gain_right[1], &_level, &_delta, &_floor, &_ceiling,
+                             &_fade_left, &_fade_count, &_fade_scale, &_filter_g, &_filter_rg, &_filter_h,
+                             &_filter_s1[0], &_filter_s1[1], &_filter_s2[0], &_filter_s2[1] })
+        {
+            *array   = aligned;
+            aligned += _capacity;
+        }
+    }
+    
+    //==============================================================================
+    // Adds num_samples of voices[first, first + num_of_voices), all playing up to
+    // unison copies of either oscillator, panned, to the left/right mix. first has to start a group,
+    // see voicesPerGroup(): calls on disjoint ranges then never share storage
+    // and may run concurrently.
+    void render (Voice* const* voices, size_t first, size_t num_of_voices, int unison, const Voice::WaveTypes& wave_types, OscillatorMode oscillator_mode,
+                 bool filtered, bool modulated, const Mix& mix, int num_samples) noexcept
+    {
+        const auto lanes_per_voice  = lanesPerVoice(unison);
+        const auto voices_per_group = voicesPerGroup(unison);
+        const auto end              = first + num_of_voices;
+        jassert (first % voices_per_group == 0);
+        jassert ((end + voices_per_group - 1) / voices_per_group * voices_per_group * lanes_per_voice <= _capacity);
+        const Kernels kernels {{ toKernel(wave_types[SynthOSC::FIRST_OSC], oscillator_mode), toKernel(wave_types[SynthOSC::SECOND_OSC], oscillator_mode) }};
+        for (size_t group = first; group < end; group += voices_per_group)
+        {
+            renderGroup(voices + group, juce::jmin(voices_per_group, end - group), voices_per_group, lanes_per_voice,
+                        group * lanes_per_voice, kernels, filtered, modulated, mix, num_samples);
+        }
+    }
+    static size_t voicesPerGroup (int unison) noexcept
+    {
+        return juce::jmax<size_t>(1, Lanes::size() / lanesPerVoice(unison));
+    }
+    
+private:
+    //==============================================================================
+    static constexpr size_t NUM_ARRAYS     = 6 * Voice::NUM_OF_OSCILLATORS + 13;
+    static constexpr size_t NUM_INT_ARRAYS = 4 * Voice::NUM_OF_OSCILLATORS;
+    
+    // what one oscillator computes per sample, picked from its waveform and the oscillator mode
+    enum Kernel
+    {
+        SIN_KERNEL,
+        TABLE_KERNEL,
+        PULSE_TABLE_KERNEL,
+        FRAMES_KERNEL,      // two frames of the user wavetable, blended
+        SAW_BLEP_KERNEL,
+        PULSE_BLEP_KERNEL,
+        TRIANGLE_BLAMP_KERNEL
+    };
+    using Kernels          = std::array<Kernel, Voice::NUM_OF_OSCILLATORS>;
+    using OscillatorArrays    = std::array<BufferData*, Voice::NUM_OF_OSCILLATORS>;
+    using OscillatorIntArrays = std::array<juce::uint32*, Voice::NUM_OF_OSCILLATORS>;
+    
+    juce::HeapBlock<BufferData>   _storage;
+    juce::HeapBlock<juce::uint32> _int_storage;
+    size_t                      _capacity  = 0;
+    OscillatorIntArrays         _phase_coarse {}; // per oscillator, see FixedPhase
+    OscillatorIntArrays         _phase_fine   {};
+    OscillatorIntArrays         _step_coarse  {}; // the fixed-point increment, split the same way
+    OscillatorIntArrays         _step_fine    {};
+    OscillatorArrays            _increment {}; // in cycles per sample, for the PolyBLEP kernels
+    OscillatorArrays            _inv_increment {}; // for the PolyBLEP kernels, 0 on silent lanes
+    BufferData*                 _pulse_width = nullptr;
+    BufferData*                 _fm_depth    = nullptr; // see Voice::setFMIndex
+    using TableLevels = std::array<juce::HeapBlock<const float*>, Voice::NUM_OF_OSCILLATORS>;
+    TableLevels                 _table_level;      // per oscillator, per lane
+    TableLevels                 _next_table_level; // the user wavetable's next frame, see Voice::updateFrames
+    BufferData*                 _frame_blend = nullptr;
+    OscillatorArrays            _gain_left  {}; // voice gain with the copy's pan law applied, 0 on silent copies
+    OscillatorArrays            _gain_right {};
+    BufferData*                 _level     = nullptr; // envelope level
+    BufferData*                 _delta     = nullptr; // envelope change per sample in the current stage
+    BufferData*                 _floor     = nullptr; // envelope bounds of the current stage
+    BufferData*                 _ceiling   = nullptr;
+    BufferData*                 _fade_left  = nullptr; // steal fade samples left, whole so any block split counts alike
+    BufferData*                 _fade_count = nullptr; // 1 while fading, 0 keeps the gain at 1
+    BufferData*                 _fade_scale = nullptr; // 1 / fade length
+    BufferData*                 _filter_g  = nullptr; // per-voice filter, see Voice::Filter
+    BufferData*                 _filter_rg = nullptr;
+    BufferData*                 _filter_h  = nullptr;
+    OscillatorArrays            _filter_s1 {}; // per oscillator, each copy runs its own
+    OscillatorArrays            _filter_s2 {};
+    
+    //==============================================================================
+    // Voice index of a group starts at lane offset + index * lanes_per_voice.
+    // Events are handled per voice, from its first lane.
+    void renderGroup (Voice* const* voices, size_t group_size, size_t voices_per_group, size_t lanes_per_voice, size_t offset,
+                      const Kernels& kernels, bool filtered, bool modulated, const Mix& mix, int num_samples) noexcept
+    {
+        for (size_t index = 0; index < voices_per_group; ++index)
+        {
+            const auto first_lane = offset + index * lanes_per_voice;
+            if (index < group_size) { loadVoice(*voices[index], first_lane, lanes_per_voice); }
+            else
+            {
+                for (size_t lane = first_lane; lane < first_lane + lanes_per_voice; ++lane)
+                {
+                    loadSilentLane(lane);
+                }
+            }
+        }
+        
+        const auto end = offset + voices_per_group * lanes_per_voice;
+        for (int done = 0; done < num_samples;)
+        {
+            auto run = num_samples - done;
+            for (size_t index = 0; index < group_size; ++index)
+            {
+                run = juce::jmin(run, samplesToNextEvent(*voices[index], offset + index * lanes_per_voice, run));
+            }
+            for (auto lanes = offset; lanes < end; lanes += Lanes::size())
+            {
+                renderRun(lanes, kernels, filtered, modulated, {{ mix[0] + done, mix[1] + done }}, run);
+            }
+            done += run;
+            for (size_t index = 0; index < group_size; ++index)
+            {
+                advanceVoice(*voices[index], offset + index * lanes_per_voice, lanes_per_voice, run);
+            }
+        }
+        
+        for (size_t index = 0; index < group_size; ++index)
+        {
+            storeVoice(*voices[index], offset + index * lanes_per_voice);
+        }
+    }
+    static Kernel toKernel (VoiceWaveType wave_type, OscillatorMode mode) noexcept
+    {
+        const auto polyblep = (mode == OscillatorMode::POLYBLEP_OSC);
+        switch (wave_type)
+        {
+            case (VoiceWaveType::SIN)      : return SIN_KERNEL;
+            case (VoiceWaveType::SAW)      : return polyblep ? SAW_BLEP_KERNEL       : TABLE_KERNEL;
+            case (VoiceWaveType::SQUARE)   : return polyblep ? PULSE_BLEP_KERNEL     : PULSE_TABLE_KERNEL;
+            case (VoiceWaveType::TRIANGLE) : return polyblep ? TRIANGLE_BLAMP_KERNEL : TABLE_KERNEL;
+            case (VoiceWaveType::USER)     : return FRAMES_KERNEL;
+        }
+        return SIN_KERNEL;
+    }
+    // The kernels and the filter and FM switches are template arguments so the inner
+    // loop has no branches, these steps pick the instantiation for this run.
+    void renderRun (size_t offset, const Kernels& kernels, bool filtered, bool modulated, const Mix& mix, int num_samples) noexcept
+    {
+        switch (kernels[SynthOSC::FIRST_OSC])
+        {
+            case (SIN_KERNEL)            : renderRunWithFirst<SIN_KERNEL>           (offset, kernels[SynthOSC::SECOND_OSC], filtered, modulated, mix, num_samples); break;
+            case (TABLE_KERNEL)          : renderRunWithFirst<TABLE_KERNEL>         (offset, kernels[SynthOSC::SECOND_OSC], filtered, modulated, mix, num_samples); break;
+            case (PULSE_TABLE_KERNEL)    : renderRunWithFirst<PULSE_TABLE_KERNEL>   (offset, kernels[SynthOSC::SECOND_OSC], filtered, modulated, mix, num_samples); break;
+            case (FRAMES_KERNEL)         : renderRunWithFirst<FRAMES_KERNEL>        (offset, kernels[SynthOSC::SECOND_OSC], filtered, modulated, mix, num_samples); break;
+            case (SAW_BLEP_KERNEL)       : renderRunWithFirst<SAW_BLEP_KERNEL>      (offset, kernels[SynthOSC::SECOND_OSC], filtered, modulated, mix, num_samples); break;
+            case (PULSE_BLEP_KERNEL)     : renderRunWithFirst<PULSE_BLEP_KERNEL>    (offset, kernels[SynthOSC::SECOND_OSC], filtered, modulated, mix, num_samples); break;
+            case (TRIANGLE_BLAMP_KERNEL) : renderRunWithFirst<TRIANGLE_BLAMP_KERNEL>(offset, kernels[SynthOSC::SECOND_OSC], filtered, modulated, mix, num_samples); break;
+        }
+    }
+    template <Kernel first_kernel>
+    void renderRunWithFirst (size_t offset, Kernel second_kernel, bool filtered, bool modulated, const Mix& mix, int num_samples) noexcept
+    {
+        switch (second_kernel)
+        {
+            case (SIN_KERNEL)            : renderRunWithKernels<first_kernel, SIN_KERNEL>           (offset, filtered, modulated, mix, num_samples); break;
+            case (TABLE_KERNEL)          : renderRunWithKernels<first_kernel, TABLE_KERNEL>         (offset, filtered, modulated, mix, num_samples); break;
+            case (PULSE_TABLE_KERNEL)    : renderRunWithKernels<first_kernel, PULSE_TABLE_KERNEL>   (offset, filtered, modulated, mix, num_samples); break;
+            case (FRAMES_KERNEL)         : renderRunWithKernels<first_kernel, FRAMES_KERNEL>        (offset, filtered, modulated, mix, num_samples); break;
+            case (SAW_BLEP_KERNEL)       : renderRunWithKernels<first_kernel, SAW_BLEP_KERNEL>      (offset, filtered, modulated, mix, num_samples); break;
+            case (PULSE_BLEP_KERNEL)     : renderRunWithKernels<first_kernel, PULSE_BLEP_KERNEL>    (offset, filtered, modulated, mix, num_samples); break;
+            case (TRIANGLE_BLAMP_KERNEL) : renderRunWithKernels<first_kernel, TRIANGLE_BLAMP_KERNEL>(offset, filtered, modulated, mix, num_samples); break;
+        }
+    }
+    template <Kernel first_kernel, Kernel second_kernel>
+    void renderRunWithKernels (size_t offset, bool filtered, bool modulated, const Mix& mix, int num_samples) noexcept
+    {
+        if (modulated) { renderRunWithFilter<first_kernel, second_kernel, true> (offset, filtered, mix, num_samples); }
+        else           { renderRunWithFilter<first_kernel, second_kernel, false>(offset, filtered, mix, num_samples); }
+    }
+    template <Kernel first_kernel, Kernel second_kernel, bool modulated>
+    void renderRunWithFilter (size_t offset, bool filtered, const Mix& mix, int num_samples) noexcept
+    {
+        if (filtered) { renderRunWith<first_kernel, second_kernel, modulated, true> (offset, mix, num_samples); }
+        else          { renderRunWith<first_kernel, second_kernel, modulated, false>(offset, mix, num_samples); }
+    }
+    template <Kernel first_kernel, Kernel second_kernel, bool modulated, bool filtered>
+    void renderRunWith (size_t offset, const Mix& mix, int num_samples) noexcept
+    {
+        const auto zero        = Lanes::expand(0.0f);
+        const auto increment_1 = Lanes::fromRawArray(_increment[SynthOSC::FIRST_OSC]  + offset);
+        const auto increment_2 = Lanes::fromRawArray(_increment[SynthOSC::SECOND_OSC] + offset);
+        const auto inv_increment_1 = Lanes::fromRawArray(_inv_increment[SynthOSC::FIRST_OSC]  + offset);
+        const auto inv_increment_2 = Lanes::fromRawArray(_inv_increment[SynthOSC::SECOND_OSC] + offset);
+        const auto pulse_width = Lanes::fromRawArray(_pulse_width + offset);
+        const auto fm_depth    = Lanes::fromRawArray(_fm_depth + offset);
+        const auto frame_blend = Lanes::fromRawArray(_frame_blend + offset);
+        const Tables tables_1 { _table_level[SynthOSC::FIRST_OSC]  + offset, _next_table_level[SynthOSC::FIRST_OSC]  + offset, frame_blend };
+        const Tables tables_2 { _table_level[SynthOSC::SECOND_OSC] + offset, _next_table_level[SynthOSC::SECOND_OSC] + offset, frame_blend };
+        const auto gain_left_1  = Lanes::fromRawArray(_gain_left[SynthOSC::FIRST_OSC]   + offset);
+        const auto gain_left_2  = Lanes::fromRawArray(_gain_left[SynthOSC::SECOND_OSC]  + offset);
+        const auto gain_right_1 = Lanes::fromRawArray(_gain_right[SynthOSC::FIRST_OSC]  + offset);
+        const auto gain_right_2 = Lanes::fromRawArray(_gain_right[SynthOSC::SECOND_OSC] + offset);
+        const auto delta       = Lanes::fromRawArray(_delta     + offset);
+        const auto floor       = Lanes::fromRawArray(_floor     + offset);
+        const auto ceiling     = Lanes::fromRawArray(_ceiling   + offset);
+        const auto fade_count  = Lanes::fromRawArray(_fade_count + offset);
+        const auto fade_scale  = Lanes::fromRawArray(_fade_scale + offset);
+        const auto step_coarse_1 = IntLanes::fromRawArray(_step_coarse[SynthOSC::FIRST_OSC]  + offset);
+        const auto step_coarse_2 = IntLanes::fromRawArray(_step_coarse[SynthOSC::SECOND_OSC] + offset);
+        const auto step_fine_1   = IntLanes::fromRawArray(_step_fine[SynthOSC::FIRST_OSC]  + offset);
+        const auto step_fine_2   = IntLanes::fromRawArray(_step_fine[SynthOSC::SECOND_OSC] + offset);
+        auto coarse_1 = IntLanes::fromRawArray(_phase_coarse[SynthOSC::FIRST_OSC]  + offset);
+        auto coarse_2 = IntLanes::fromRawArray(_phase_coarse[SynthOSC::SECOND_OSC] + offset);
+        auto fine_1   = IntLanes::fromRawArray(_phase_fine[SynthOSC::FIRST_OSC]  + offset);
+        auto fine_2   = IntLanes::fromRawArray(_phase_fine[SynthOSC::SECOND_OSC] + offset);
+        auto level   = Lanes::fromRawArray(_level + offset);
+        auto fade_left = Lanes::fromRawArray(_fade_left + offset);
+        const auto filter_g  = Lanes::fromRawArray(_filter_g  + offset);
+        const auto filter_rg = Lanes::fromRawArray(_filter_rg + offset);
+        const auto filter_h  = Lanes::fromRawArray(_filter_h  + offset);
+        auto filter_s1_1 = Lanes::fromRawArray(_filter_s1[SynthOSC::FIRST_OSC]  + offset);
+        auto filter_s1_2 = Lanes::fromRawArray(_filter_s1[SynthOSC::SECOND_OSC] + offset);
+        auto filter_s2_1 = Lanes::fromRawArray(_filter_s2[SynthOSC::FIRST_OSC]  + offset);
+        auto filter_s2_2 = Lanes::fromRawArray(_filter_s2[SynthOSC::SECOND_OSC] + offset);
+        
+        for (int sample = 0; sample < num_samples; ++sample)
+        {
+            level = Lanes::min(Lanes::max(level + delta, floor), ceiling);
+            fade_left = Lanes::max(fade_left - fade_count, zero);
+            const auto phase_2    = FixedPhase::toFloat(coarse_2);
+            const auto modulation = generate<second_kernel>(phase_2, increment_2, inv_increment_2, pulse_width, tables_2);
+            auto phase_1 = FixedPhase::toFloat(coarse_1);
+            if (modulated) // OSC #2 bends the phase of OSC #1, see Voice::renderSample
+            {
+                phase_1 = FastMath::wrap(phase_1 + modulation * fm_depth);
+            }
+            auto voices_1 = generate<first_kernel>(phase_1, increment_1, inv_increment_1, pulse_width, tables_1);
+            auto voices_2 = modulation;
+            if (filtered) // one filter per copy, see Voice::filterSample
+            {
+                voices_1 = filter(voices_1, filter_s1_1, filter_s2_1, filter_g, filter_rg, filter_h);
+                voices_2 = filter(voices_2, filter_s1_2, filter_s2_2, filter_g, filter_rg, filter_h);
+            }
+            const auto envelope = level * (fade_left * fade_scale);
+            voices_1 = voices_1 * envelope;
+            voices_2 = voices_2 * envelope;
+            mix[0][sample] += (voices_1 * gain_left_1  + voices_2 * gain_left_2).sum();
+            mix[1][sample] += (voices_1 * gain_right_1 + voices_2 * gain_right_2).sum();
+            FixedPhase::advance(coarse_1, fine_1, step_coarse_1, step_fine_1);
+            FixedPhase::advance(coarse_2, fine_2, step_coarse_2, step_fine_2);
+        }
+        
+        coarse_1.copyToRawArray(_phase_coarse[SynthOSC::FIRST_OSC]  + offset);
+        coarse_2.copyToRawArray(_phase_coarse[SynthOSC::SECOND_OSC] + offset);
+        fine_1.copyToRawArray(_phase_fine[SynthOSC::FIRST_OSC]  + offset);
+        fine_2.copyToRawArray(_phase_fine[SynthOSC::SECOND_OSC] + offset);
+        level.copyToRawArray(_level + offset);
+        fade_left.copyToRawArray(_fade_left + offset);
+        filter_s1_1.copyToRawArray(_filter_s1[SynthOSC::FIRST_OSC]  + offset);
+        filter_s1_2.copyToRawArray(_filter_s1[SynthOSC::SECOND_OSC] + offset);
+        filter_s2_1.copyToRawArray(_filter_s2[SynthOSC::FIRST_OSC]  + offset);
+        filter_s2_2.copyToRawArray(_filter_s2[SynthOSC::SECOND_OSC] + offset);
+    }
+    static Lanes filter (Lanes input, Lanes& s1, Lanes& s2, Lanes g, Lanes rg, Lanes h) noexcept
+    {
+        const auto high = (input - s1 * rg - s2) * h;
+        const auto band = high * g + s1;
+        s1              = high * g + band;
+        const auto low  = band * g + s2;
+        s2              = band * g + low;
+        return low;
+    }
+    
+    //==============================================================================
+    // Per lane table levels of one oscillator for this run.
+    struct Tables
+    {
+        const float* const* levels;
+        const float* const* next_levels;
+        Lanes               blend;
+    };
+    
+    //==============================================================================
+    // Same waveforms as Voice::generate, the switch is resolved at compile time.
+    template <Kernel kernel>
+    static Lanes generate (Lanes phase, Lanes increment, Lanes inv_increment, Lanes pulse_width, const Tables& tables) noexcept
+    {
+        switch (kernel)
+        {
+            case (SIN_KERNEL)            : return FastMath::sin2pi(phase);
+            case (TABLE_KERNEL)          : return generateFromTables(phase, tables.levels);
+            case (PULSE_TABLE_KERNEL)    : return generateFromTables(wrapPhase(phase + (Lanes::expand(1.0f) - pulse_width)), tables.levels)
+                                                - generateFromTables(phase, tables.levels);
+            case (FRAMES_KERNEL)         : return generateFromFrames(phase, tables);
+            case (SAW_BLEP_KERNEL)       : return PolyBLEP::saw(phase, increment, inv_increment);
+            case (PULSE_BLEP_KERNEL)     : return PolyBLEP::pulse(phase, increment, inv_increment, pulse_width);
+            case (TRIANGLE_BLAMP_KERNEL) : return PolyBLEP::triangle(phase, increment, inv_increment);
+        }
+        return phase;
+    }
+    static Lanes generateFromTables (Lanes phase, const float* const* table_levels) noexcept
+    {
+        // no gather in SIMDRegister, every lane reads its own table level
+        Lanes value;
+        for (size_t lane = 0; lane < Lanes::size(); ++lane)
+        {
+            value.set(lane, (table_levels[lane] != nullptr) ? Wavetable::lookup(table_levels[lane], phase.get(lane)) : 0.0f);
+        }
+        return value;
+    }
+    // Both frames in one pass per lane, blended per sample: moving the
+    // position only swaps the level pointers, nothing is rebuilt.
+    static Lanes generateFromFrames (Lanes phase, const Tables& tables) noexcept
+    {
+        Lanes value;
+        for (size_t lane = 0; lane < Lanes::size(); ++lane)
+        {
+            const auto* level = tables.levels[lane];
+            value.set(lane, (level != nullptr) ? Wavetable::lookup(level, tables.next_levels[lane], tables.blend.get(lane), phase.get(lane)) : 0.0f);
+        }
+        return value;
+    }
+    static Lanes wrapPhase (Lanes phase) noexcept
+    {
+        const auto one = Lanes::expand(1.0f);
+        return phase - (one & Lanes::greaterThanOrEqual(phase, one));
+    }
+    
+    //==============================================================================
+    // The copies of the voice, then silent lanes up to lanes_per_voice.
+    void loadVoice (Voice& voice, size_t first_lane, size_t lanes_per_voice) noexcept
+    {
+        const auto num_of_copies = static_cast<size_t>(voice.getNumOfCopies());
+        jassert (num_of_copies <= lanes_per_voice);
+        for (size_t copy = 0; copy < lanes_per_voice; ++copy)
+        {
+            if (copy < num_of_copies) { loadLane(voice, copy, first_lane + copy); }
+            else                      { loadSilentLane(first_lane + copy); }
+        }
+    }
+    // Only the lanes that hold a copy of their own, not OSC #2's repeats.
+    void storeVoice (Voice& voice, size_t first_lane) noexcept
+    {
+        for (size_t osc = 0; osc < Voice::NUM_OF_OSCILLATORS; ++osc)
+        {
+            auto& oscillator = voice._oscillators[osc];
+            for (size_t copy = 0; copy < static_cast<size_t>(oscillator.unison); ++copy)
+            {
+                const auto lane = first_lane + copy;
+                auto& state     = oscillator.copies[copy];
+                state.phase     = FixedPhase::join(_phase_coarse[osc][lane], _phase_fine[osc][lane]);
+                state.filter    = { _filter_s1[osc][lane], _filter_s2[osc][lane] };
+            }
+        }
+    }
+    // The copy of an oscillator lane copy plays: OSC #2 repeats its copies over
+    // the lanes past its last one, OSC #1 has none there.
+    static const Voice::Copy* getLaneCopy (const Voice& voice, size_t osc, size_t copy) noexcept
+    {
+        const auto& oscillator = voice._oscillators[osc];
+        const auto  unison     = static_cast<size_t>(oscillator.unison);
+        if (osc == SynthOSC::SECOND_OSC)
+        {
+            return &oscillator.copies[copy % unison];
+        }
+        return (copy < unison) ? &oscillator.copies[copy] : nullptr;
+    }
+    void loadLane (Voice& voice, size_t copy, size_t lane) noexcept
+    {
+        for (size_t osc = 0; osc < Voice::NUM_OF_OSCILLATORS; ++osc)
+        {
+            const auto* state   = getLaneCopy(voice, osc, copy);
+            const auto  audible = copy < static_cast<size_t>(voice._oscillators[osc].unison); // a repeat only modulates
+            _phase_coarse[osc][lane] = (state != nullptr) ? FixedPhase::coarse(state->phase) : 0;
+            _phase_fine[osc][lane]   = (state != nullptr) ? FixedPhase::fine(state->phase)   : 0;
+            _gain_left[osc][lane]    = audible ? voice._gain * state->gains[0] : 0.0f;
+            _gain_right[osc][lane]   = audible ? voice._gain * state->gains[1] : 0.0f;
+            _filter_s1[osc][lane]    = (state != nullptr) ? state->filter.s1 : 0.0f;
+            _filter_s2[osc][lane]    = (state != nullptr) ? state->filter.s2 : 0.0f;
+            jassert (voice._oscillators[osc].fade_left == 0); // waveform fades are rendered per voice
+        }
+        loadIncrements(voice, copy, lane);
+        _pulse_width[lane] = voice._pulse_width;
+        _fm_depth[lane]    = voice._fm_depth;
+        _filter_g[lane]   = voice._filter.g;
+        _filter_rg[lane]  = voice._filter.rg;
+        _filter_h[lane]   = voice._filter.h;
+        if (voice._steal_fade_left > 0)
+        {
+            _fade_left[lane]  = static_cast<float>(voice._steal_fade_left);
+            _fade_count[lane] = 1.0f;
+            _fade_scale[lane] = 1.0f / static_cast<float>(voice._steal_fade_length);
+        } else
+        {
+            _fade_left[lane]  = _fade_scale[lane] = 1.0f;
+            _fade_count[lane] = 0.0f;
+        }
+        loadEnvelope(voice._adsr, lane);
+    }
+    // Pitch and tables only, glide and position steps reload them in the middle of a block.
+    void loadIncrements (const Voice& voice, size_t copy, size_t lane) noexcept
+    {
+        for (size_t osc = 0; osc < Voice::NUM_OF_OSCILLATORS; ++osc)
+        {
+            const auto& oscillator = voice._oscillators[osc];
+            const auto* state      = getLaneCopy(voice, osc, copy);
+            if (state == nullptr)
+            {
+                _step_coarse[osc][lane] = _step_fine[osc][lane] = 0;
+                _increment[osc][lane]   = _inv_increment[osc][lane] = 0.0f;
+                _table_level[osc][lane] = _next_table_level[osc][lane] = nullptr;
+                continue;
+            }
+            _step_coarse[osc][lane]   = FixedPhase::coarse(state->increment);
+            _step_fine[osc][lane]     = FixedPhase::fine(state->increment);
+            _increment[osc][lane]     = state->phase_increment;
+            _inv_increment[osc][lane] = (_increment[osc][lane] > 0.0f) ? 1.0f / _increment[osc][lane] : 0.0f;
+            _table_level[osc][lane]   = oscillator.source.table_level;
+            _next_table_level[osc][lane] = oscillator.source.next_table_level;
+        }
+        _frame_blend[lane] = voice._frame_blend;
+    }
+    void loadSilentLane (size_t lane) noexcept
+    {
+        for (size_t osc = 0; osc < Voice::NUM_OF_OSCILLATORS; ++osc)
+        {
+            _phase_coarse[osc][lane] = _phase_fine[osc][lane] = _step_coarse[osc][lane] = _step_fine[osc][lane] = 0;
+            _increment[osc][lane] = _inv_increment[osc][lane] = 0.0f;
+            _table_level[osc][lane] = _next_table_level[osc][lane] = nullptr;
+            _gain_left[osc][lane] = _gain_right[osc][lane] = _filter_s1[osc][lane] = _filter_s2[osc][lane] = 0.0f;
+        }
+        _frame_blend[lane] = 0.0f;
+        _pulse_width[lane] = 0.5f;
+        _fm_depth[lane]    = 0.0f;
+        _filter_g[lane]  = _filter_rg[lane] = _filter_h[lane] = 0.0f;
+        _level[lane] = _delta[lane] = _floor[lane] = _ceiling[lane] = 0.0f;
+        _fade_left[lane] = _fade_count[lane] = _fade_scale[lane] = 0.0f;
+    }
+    void loadEnvelope (const ADSRProcessor& adsr, size_t lane) noexcept
+    {
+        _level[lane] = adsr._level;
+        if (!adsr._is_active)
+        {
+            _delta[lane] = _floor[lane] = _ceiling[lane] = 0.0f;
+            return;
+        }
+        switch (adsr._stage)
+        {
+            case (ADSRStages::ATTACK):
+                _delta[lane] = adsr._attack_rate; _floor[lane] = 0.0f; _ceiling[lane] = 1.0f;
+                break;
+            case (ADSRStages::DECAY):
+                _delta[lane] = -adsr._decay_rate; _floor[lane] = adsr._sustain; _ceiling[lane] = 1.0f;
+                break;
+            case (ADSRStages::SUSTAIN):
+                _delta[lane] = 0.0f; _floor[lane] = adsr._sustain; _ceiling[lane] = adsr._sustain;
+                break;
+            case (ADSRStages::RELEASE):
+                _delta[lane] = -adsr._release_rate; _floor[lane] = 0.0f; _ceiling[lane] = adsr._level;
+                break;
+        }
+    }
+    int samplesToNextEvent (const Voice& voice, size_t lane, int max_samples) const noexcept
+    {
+        auto next = max_samples;
+        if (voice._steal_fade_left > 0)
+        {
+            next = juce::jmin(next, voice._steal_fade_left);
+        }
+        if (voice._glide_steps_left > 0)
+        {
+            next = juce::jmin(next, voice._glide_countdown);
+        }
+        if (voice._position_steps_left > 0)
+        {
+            next = juce::jmin(next, voice._position_countdown);
+        }
+        
+        const auto& adsr = voice._adsr;
+        if (!adsr._is_active || adsr._stage == ADSRStages::SUSTAIN)
+        {
+            return next;
+        }
+        const auto rate     = std::abs(_delta[lane]);
+        const auto distance = (adsr._stage == ADSRStages::ATTACK) ? 1.0f - _level[lane] : _level[lane] - _floor[lane];
+        if (rate <= 0.0f || distance <= 0.0f)
+        {
+            return 1;
+        }
+        // a sample short of the estimate, which rounding can make one too long:
+        // the last step then runs on its own and the stage changes on time,
+        // wherever the block was split before
+        const auto to_target = std::ceil(juce::jmin(distance / rate, static_cast<float>(next))) - 1.0f;
+        return juce::jlimit(1, next, static_cast<int>(to_target));
+    }
+    // Mirrors the stage changes ADSRProcessor::getNextSample makes on its own.
+    // The copies share the envelope, the first lane stands for all of them.
+    void advanceVoice (Voice& voice, size_t first_lane, size_t lanes_per_voice, int num_samples) noexcept
+    {
+        auto& adsr  = voice._adsr;
+        adsr._level = _level[first_lane];
+        
+        const auto num_of_copies = static_cast<size_t>(voice.getNumOfCopies());
+        const auto glide_step    = (voice._glide_steps_left > 0)    && voice.advanceGlide(num_samples);
+        const auto position_step = (voice._position_steps_left > 0) && voice.advancePosition(num_samples);
+        if (glide_step || position_step) // both change the table levels too
+        {
+            for (size_t copy = 0; copy < num_of_copies; ++copy)
+            {
+                loadIncrements(voice, copy, first_lane + copy);
+            }
+        }
+        if (voice._steal_fade_left > 0)
+        {
+            voice._steal_fade_left -= num_samples;
+            if (voice._steal_fade_left == 0)
+            {
+                storeVoice(voice, first_lane);
+                voice.startNote();
+                loadVoice(voice, first_lane, lanes_per_voice);
+                return;
+            }
+        }
+        if (!adsr._is_active)
+        {
+            return;
+        }
+        switch (adsr._stage)
+        {
+            case (ADSRStages::ATTACK):
+                if (adsr._level >= 1.0f)
+                {
+                    adsr._level = 1.0f;
+                    adsr._stage = (adsr._decay_rate > 0.0f) ? ADSRStages::DECAY : ADSRStages::SUSTAIN;
+                }
+                break;
+            case (ADSRStages::DECAY):
+                if (adsr._level <= adsr._sustain)
+                {
+                    adsr._level = adsr._sustain;
+                    adsr._stage = ADSRStages::SUSTAIN;
+                }
+                break;
+            case (ADSRStages::SUSTAIN):
+                break;
+            case (ADSRStages::RELEASE):
+                if (adsr._level <= 0.0f)
+                {
+                    adsr.reset();
+                }
+                break;
+        }
+        for (size_t copy = 0; copy < num_of_copies; ++copy)
+        {
+            loadEnvelope(adsr, first_lane + copy);
+        }
+    }
+};
+
+
+//==============================================================================
+class VoiceManager : public IAudioProcessor
+{
+public:
+    //==============================================================================
+    using VoiceNum = unsigned int;
+    
+    static constexpr VoiceNum MAX_NUM_OF_VOICES = 256;
+    
+    // Worker threads only pay for their synchronisation with enough bank lanes
+    // (voices times their unison lanes) to go around; each of them renders
+    // whole tasks of about LANES_PER_TASK.
+    static constexpr size_t LANES_PER_TASK        = 16;
+    static constexpr size_t MIN_LANES_FOR_WORKERS = 32;
+    // semitones at full pitch wheel deflection
+    static constexpr float  PITCH_BEND_RANGE       = 2.0f;
+    
+    //==============================================================================
+    VoiceManager (IAudioProcessor::SynthStatePtr state_ptr): IAudioProcessor(state_ptr)
+    {
+        using namespace std::placeholders;
+        
+        for (auto stage : { ADSRStages::ATTACK, ADSRStages::DECAY, ADSRStages::SUSTAIN, ADSRStages::RELEASE })
+        {
+            _amp_adsr[stage] = getSynthState()->getAmpADSR(stage);
+            getSynthState()->onAmpADSRChange(stage, std::bind(&VoiceManager::onAmpADSRChange, this, stage, _1));
+        }
+        
+        setPan(getSynthState()->getAmpPan());
+        getSynthState()->onAmpPanChange(std::bind(&VoiceManager::setPan, this, _1));
+        
+        _filter_settings.enabled      = getSynthState()->getFilterMode() == FilterMode::PER_VOICE_FILTER;
+        _filter_settings.cutoff       = getSynthState()->getFilterCutoff();
+        _filter_settings.q            = getSynthState()->getFilterQ();
+        _filter_settings.key_tracking = getSynthState()->getFilterKeyTracking();
+        _filter_settings.velocity     = getSynthState()->getFilterVelocity();
+        getSynthState()->onFilterModeChange(std::bind(&VoiceManager::setFilterMode, this, _1));
+        getSynthState()->onFilterCutoffChange(std::bind(&VoiceManager::setFilterCutoff, this, _1));
+        getSynthState()->onFilterQChange(std::bind(&VoiceManager::setFilterQ, this, _1));
+        getSynthState()->onFilterKeyTrackingChange(std::bind(&VoiceManager::setFilterKeyTracking, this, _1));
+        getSynthState()->onFilterVelocityChange(std::bind(&VoiceManager::setFilterVelocity, this, _1));
+        
+        setStealPolicy(getSynthState()->getVoiceStealPolicy());
+        getSynthState()->onVoiceStealPolicyChange(std::bind(&VoiceManager::setStealPolicy, this, _1));
+        
+        setRenderMode(getSynthState()->getVoiceRenderMode());
+        getSynthState()->onVoiceRenderModeChange(std::bind(&VoiceManager::setRenderMode, this, _1));
+        
+        setWaveCrossfade(getSynthState()->getWaveCrossfade());
+        getSynthState()->onWaveCrossfadeChange(std::bind(&VoiceManager::setWaveCrossfade, this, _1));
+        
+        setOscillatorMode(getSynthState()->getOscillatorMode());
+        getSynthState()->onOscillatorModeChange(std::bind(&VoiceManager::setOscillatorMode, this, _1));
+        setPulseWidth(getSynthState()->getPulseWidth());
+        getSynthState()->onPulseWidthChange(std::bind(&VoiceManager::setPulseWidth, this, _1));
+        for (auto osc : { SynthOSC::FIRST_OSC, SynthOSC::SECOND_OSC })
+        {
+            setFineTune(osc, getSynthState()->getFineTune(osc));
+            getSynthState()->onFineTuneChange(osc, std::bind(&VoiceManager::setFineTune, this, osc, _1));
+        }
+        setGlideTime(getSynthState()->getGlideTime());
+        getSynthState()->onGlideTimeChange(std::bind(&VoiceManager::setGlideTime, this, _1));
+        for (auto osc : { SynthOSC::FIRST_OSC, SynthOSC::SECOND_OSC })
+        {
+            setUnisonVoices(osc, getSynthState()->getUnisonVoices(osc));
+            getSynthState()->onUnisonVoicesChange(osc, std::bind(&VoiceManager::setUnisonVoices, this, osc, _1));
+            setUnisonDetune(osc, getSynthState()->getUnisonDetune(osc));
+            getSynthState()->onUnisonDetuneChange(osc, std::bind(&VoiceManager::setUnisonDetune, this, osc, _1));
+            setUnisonSpread(osc, getSynthState()->getUnisonSpread(osc));
+            getSynthState()->onUnisonSpreadChange(osc, std::bind(&VoiceManager::setUnisonSpread, this, osc, _1));
+        }
+        setFMIndex(getSynthState()->getFMIndex());
+        getSynthState()->onFMIndexChange(std::bind(&VoiceManager::setFMIndex, this, _1));
+        setWavetablePosition(getSynthState()->getWavetablePosition());
+        getSynthState()->onWavetablePositionChange(std::bind(&VoiceManager::setWavetablePosition, this, _1));
+        
+        for (auto wave_type : { VoiceWaveType::SIN, VoiceWaveType::SAW, VoiceWaveType::SQUARE, VoiceWaveType::TRIANGLE })
+        {
+            Voice::getSharedWavetable(wave_type); // build the shared tables here, never on the audio thread
+        }
+        _bank.prepare(MAX_NUM_OF_VOICES);
+        _voices.ensureStorageAllocated(static_cast<int>(MAX_NUM_OF_VOICES)); // pool never grows past this
+        setNumOfVoices(getSynthState()->getNumOfVoices());
+        setNumOfRenderThreads(getSynthState()->getNumOfRenderThreads());
+    }
+    ~VoiceManager ()
+    {
+        reset();
+        _voices.clear();
+    }
+    
+    //==============================================================================
+    void prepare (const IAudioProcessorConfig &spec) noexcept override
+    {
+        _spec = spec;
+        _is_prepared = true;
+        for (auto& bus : _buses)
+        {
+            prepareBus(bus);
+        }
+        setNumOfVoices(getSynthState()->getNumOfVoices());
+        setGlideTime(_glide_time); // in samples, depends on the rate
+        forEachVoice([&spec](auto& voice) { voice->prepare(spec); });
+    }
+    void process (const IAudioProcessContext &context) noexcept override
+    {
+        auto& outputBlock = context.juce_context.getOutputBlock(); // get output audio block
+        
+        // hosts may exceed the block size announced in prepare(), render in chunks then
+        const auto max_chunk = static_cast<size_t>(_buses.front().voice.getNumSamples());
+        if (max_chunk == 0) return; // not prepared yet
+        for (size_t start = 0; start < outputBlock.getNumSamples(); start += max_chunk)
+        {
+            auto chunk = outputBlock.getSubBlock(start, juce::jmin(max_chunk, outputBlock.getNumSamples() - start));
+            processChunk(chunk);
+        }
+    }
+    void reset () noexcept override
+    {
+        rebuildVoiceLists();
+    }
+    
+    //==============================================================================
+    void noteOn (const juce::MidiMessage& midiMessage)
+    {
+        const auto note     = midiMessage.getNoteNumber();
+        const auto velocity = static_cast<int>(midiMessage.getVelocity());
+        auto* same_note     = _note_to_voice[note];
+        const auto glide_from = _last_note; // every new note slides from the one played before it
+        _last_note = note;
+        
+        if (same_note != nullptr && _steal_policy == VoiceStealPolicy::SAME_NOTE)
+        {
+            // retrigger the voice that already plays this note
+            _active_voices.remove(same_note);
+            _active_voices.pushBack(same_note);
+            same_note->steal(note, velocity, glide_from);
+            return;
+        }
+        if (same_note != nullptr && same_note->isHeld())
+        {
+            same_note->noteOff(); // the index only follows the newest voice, don't leave this one hanging
+        }
+        
+        // try to play note using free voice
+        if (auto* voice = _free_voices.popFront())
+        {
+            _active_voices.pushBack(voice); // active list stays ordered by note start
+            _note_to_voice[note] = voice;
+            applyTuning(*voice);
+            voice->noteOn(note, velocity, glide_from);
+            return;
+        }
+        
+        // steal voice if there are no free voices available
+        if (auto* voice = findVoiceToSteal())
+        {
+            unmapNote(voice);
+            _active_voices.remove(voice);
+            _active_voices.pushBack(voice);
+            _note_to_voice[note] = voice;
+            voice->steal(note, velocity, glide_from);
+        }
+    }
+    void noteOff (const juce::MidiMessage& midiMessage)
+    {
+        auto* voice = _note_to_voice[midiMessage.getNoteNumber()];
+        if (voice != nullptr && voice->isHeld())
+        {
+            voice->noteOff(); // stays mapped while it releases, for same-note retrigger
+        }
+    }
+    // value is the 14-bit pitch wheel position, 8192 is centred
+    void pitchWheelMoved(int value)
+    {
+        const auto bend = static_cast<float>(value - 8192) / 8192.0f * PITCH_BEND_RANGE;
+        _active_voices.forEach([bend](Voice* voice) { voice->setPitchBend(bend); });
+        _pitch_bend = bend;
+    }
+    void setStealPolicy(VoiceStealPolicy steal_policy)
+    {
+        _steal_policy = steal_policy;
+    }
+    void setPan(float pan)
+    {
+        _pan = pan;
+        forEachVoice([pan](auto& voice) { voice->setPan(pan); });
+    }
+    void setFilterMode(FilterMode mode)
+    {
+        _filter_settings.enabled = (mode == FilterMode::PER_VOICE_FILTER);
+        applyFilterSettings();
+    }
+    void setFilterCutoff(float cutoff)
+    {
+        _filter_settings.cutoff = cutoff;
+        applyFilterSettings();
+    }
+    void setFilterQ(float q)
+    {
+        _filter_settings.q = q;
+        applyFilterSettings();
+    }
+    void setFilterKeyTracking(float amount)
+    {
+        _filter_settings.key_tracking = amount;
+        applyFilterSettings();
+    }
+    void setFilterVelocity(float amount)
+    {
+        _filter_settings.velocity = amount;
+        applyFilterSettings();
+    }
+    void setRenderMode(VoiceRenderMode render_mode)
+    {
+        _render_mode = render_mode; // both paths share the voice state, switching is seamless
+    }
+    void setTranspose(SynthOSC osc, VoiceTranspose transpose)
+    {
+        _transposes[osc] = transpose;
+        forEachVoice([osc, &transpose](auto voice) {
+            voice->setTranspose(osc, transpose);
+        });
+    }
+    // Called from the audio thread: the voices only swap table pointers.
+    void setWaveType(SynthOSC osc, VoiceWaveType wave_type)
+    {
+        const auto fade_length = _is_prepared ? juce::roundToInt(_spec.juce_spec.sampleRate * _wave_crossfade / 1000.0) : 0;
+        _wave_types[osc] = wave_type;
+        _wave_fade_left  = juce::jmax(_wave_fade_left, fade_length);
+        forEachVoice([osc, wave_type, fade_length](auto voice) { voice->setWaveType(osc, wave_type, fade_length); });
+    }
+    void setWaveCrossfade(float milliseconds)
+    {
+        _wave_crossfade = juce::jmax(0.0f, milliseconds); // used from the next switch on
+    }
+    // Audio thread, between blocks: the table is built and owned elsewhere.
+    void setUserWavetable(const UserWavetable* table)
+    {
+        _user_wavetable = table;
+        forEachVoice([table](auto& voice) { voice->setUserWavetable(table); });
+    }
+    void setOscillatorMode(OscillatorMode mode)
+    {
+        _oscillator_mode = mode;
+        forEachVoice([mode](auto& voice) { voice->setOscillatorMode(mode); });
+    }
+    void setPulseWidth(float width)
+    {
+        _pulse_width = width;
+        forEachVoice([width](auto& voice) { voice->setPulseWidth(width); });
+    }
+    void setFineTune(SynthOSC osc, float cents)
+    {
+        _fine_tunes[osc] = cents;
+        _active_voices.forEach([osc, cents](Voice* voice) { voice->setFineTune(osc, cents); });
+    }
+    void setGlideTime(float milliseconds)
+    {
+        _glide_time = juce::jmax(0.0f, milliseconds);
+        const auto glide_length = _is_prepared ? juce::roundToInt(_spec.juce_spec.sampleRate * _glide_time / 1000.0) : 0;
+        forEachVoice([glide_length](auto& voice) { voice->setGlideLength(glide_length); });
+    }
+    // Sounding notes thicken or thin out right away, one envelope each whatever the count.
+    // Every voice follows, the bank gives them all the same number of lanes.
+    void setUnisonVoices(SynthOSC osc, int num_of_copies)
+    {
+        const auto unison = juce::jlimit(1, Voice::MAX_UNISON, num_of_copies);
+        _unison[osc] = unison;
+        forEachVoice([osc, unison](auto& voice) { voice->setUnisonVoices(osc, unison); });
+    }
+    void setUnisonDetune(SynthOSC osc, float cents)
+    {
+        _unison_detunes[osc] = cents;
+        _active_voices.forEach([osc, cents](Voice* voice) { voice->setUnisonDetune(osc, cents); });
+    }
+    void setUnisonSpread(SynthOSC osc, float amount)
+    {
+        _unison_spreads[osc] = amount;
+        forEachVoice([osc, amount](auto& voice) { voice->setUnisonSpread(osc, amount); });
+    }
+    void setFMIndex(float index)
+    {
+        _fm_index = index;
+        forEachVoice([index](auto& voice) { voice->setFMIndex(index); });
+    }
+    void setWavetablePosition(float position)
+    {
+        _wavetable_position = position; // sounding voices smooth their way there
+        forEachVoice([position](auto& voice) { voice->setWavetablePosition(position); });
+    }
+    
+    //==============================================================================
+    // Grows or shrinks the pool. Allocates, so call it from prepare() or while
+    // processing is suspended, never from the audio thread.
+    void setNumOfVoices(VoiceNum num_of_voices)
+    {
+        num_of_voices = juce::jlimit<VoiceNum>(1, MAX_NUM_OF_VOICES, num_of_voices);
+        while (getNumOfVoices() > num_of_voices)
+        {
+            _voices.removeLast();
+        }
+        while (getNumOfVoices() < num_of_voices)
+        {
+            _voices.add(createVoice());
+        }
+        rebuildVoiceLists();
+    }
+    VoiceNum getNumOfVoices() const
+    {
+        return static_cast<VoiceNum>(_voices.size());
+    }
+    VoiceNum getNumOfActiveVoices() const
+    {
+        return static_cast<VoiceNum>(_active_voices.size());
+    }
+    // Starts or stops worker threads, same rules as setNumOfVoices().
+    // 1 renders everything on the audio thread.
+    void setNumOfRenderThreads(unsigned int num_of_threads)
+    {
+        const auto max_threads = static_cast<unsigned int>(juce::jmax(1, juce::SystemStats::getNumCpus()));
+        num_of_threads = juce::jlimit(1u, max_threads, num_of_threads);
+        
+        _worker_pool.reset();
+        if (num_of_threads > 1)
+        {
+            _worker_pool = std::make_unique<RealtimeWorkerPool>(static_cast<int>(num_of_threads) - 1);
+        }
+        _buses.resize(num_of_threads); // one per participant, the audio thread uses the first
+        for (auto& bus : _buses)
+        {
+            prepareBus(bus);
+        }
+    }
+    
+private:
+    //==============================================================================
+    using VoicePtr  = std::shared_ptr<Voice>;
+    using VoiceList = IntrusiveList<Voice>;
+    
+    //==============================================================================
+    juce::Array<VoicePtr>         _voices;
+    VoiceList                     _active_voices; // sounding, oldest first, the only ones rendered
+    VoiceList                     _free_voices;   // idle, used as a stack so the last freed voice is reused first
+    std::array<Voice*, 128>       _note_to_voice {}; // newest voice per MIDI note, held or releasing
+    VoiceStealPolicy              _steal_policy = VoiceStealPolicy::OLDEST;
+    
+    //==============================================================================
+    struct RenderBus
+    {
+        juce::AudioBuffer<BufferData> voice; // left/right per-voice scratch
+        juce::AudioBuffer<BufferData> mix;   // panned left/right sum of the voices rendered here
+    };
+    
+    //==============================================================================
+    std::atomic<VoiceRenderMode>                _render_mode { VoiceRenderMode::SIMD_BANK };
+    VoiceBank                                   _bank;
+    std::array<Voice*, MAX_NUM_OF_VOICES>       _render_voices {}; // active voices gathered for this chunk
+    std::vector<RenderBus>                      _buses;            // sized in prepare(), first one is the result
+    std::unique_ptr<RealtimeWorkerPool>         _worker_pool;      // null when rendering on the audio thread only
+    IAudioProcessorConfig         _spec;
+    bool                          _is_prepared = false;
+    
+    //==============================================================================
+    // settings every voice of this manager shares, applied to newly created voices
+    Voice::WaveTypes             _wave_types {{ VoiceWaveType::SIN, VoiceWaveType::SIN }};
+    std::array<VoiceTranspose, Voice::NUM_OF_OSCILLATORS> _transposes {{ VoiceTranspose::NO_TRANSPOSE, VoiceTranspose::NO_TRANSPOSE }};
+    std::array<float, 4>         _amp_adsr {};
+    float                        _pan = 0.0f;
+    Voice::FilterSettings        _filter_settings;
+    OscillatorMode               _oscillator_mode = OscillatorMode::WAVETABLE_OSC;
+    float                        _pulse_width = 0.5f;
+    std::array<float, Voice::NUM_OF_OSCILLATORS> _fine_tunes {};
+    float                        _pitch_bend = 0.0f;
+    float                        _glide_time = 0.0f;     // milliseconds
+    std::array<int, Voice::NUM_OF_OSCILLATORS>   _unison {{ 1, 1 }};
+    std::array<float, Voice::NUM_OF_OSCILLATORS> _unison_detunes {}; // cents
+    std::array<float, Voice::NUM_OF_OSCILLATORS> _unison_spreads {};
+    float                        _fm_index      = 0.0f;  // radians
+    float                        _wavetable_position = 0.0f;
+    const UserWavetable*         _user_wavetable = nullptr;
+    int                          _last_note  = -1;       // glides start from it
+    float                        _wave_crossfade = 0.0f; // milliseconds
+    int                          _wave_fade_left = 0;    // samples until every voice plays a single waveform again
+    
+    //==============================================================================
+    VoicePtr createVoice()
+    {
+        auto voice = std::make_shared<Voice>(getSynthState());
+        voice->setOscillatorMode(_oscillator_mode); // before the waveforms, they pick it up
+        voice->setPulseWidth(_pulse_width);
+        voice->setFMIndex(_fm_index);
+        voice->setWavetablePosition(_wavetable_position); // not sounding yet, no smoothing
+        voice->setUserWavetable(_user_wavetable); // before the waveforms too
+        for (auto osc : { SynthOSC::FIRST_OSC, SynthOSC::SECOND_OSC })
+        {
+            voice->setWaveType(osc, _wave_types[osc]);
+            voice->setTranspose(osc, _transposes[osc]);
+        }
+        applyTuning(*voice);
+        for (auto osc : { SynthOSC::FIRST_OSC, SynthOSC::SECOND_OSC })
+        {
+            voice->setUnisonVoices(osc, _unison[osc]);
+            voice->setUnisonSpread(osc, _unison_spreads[osc]);
+        }
+        voice->setPan(_pan);
+        voice->setFilterSettings(_filter_settings);
+        for (auto stage : { ADSRStages::ATTACK, ADSRStages::DECAY, ADSRStages::SUSTAIN, ADSRStages::RELEASE })
+        {
+            voice->setADSRParameter(stage, _amp_adsr[stage]);
+        }
+        if (_is_prepared)
+        {
+            voice->prepare(_spec);
+            voice->setGlideLength(juce::roundToInt(_spec.juce_spec.sampleRate * _glide_time / 1000.0));
+        }
+        return voice;
+    }
+    // Bend, fine tune and detune only reach sounding voices as they change;
+    // a free voice takes them from here as it starts a note.
+    void applyTuning(Voice& voice)
+    {
+        for (auto osc : { SynthOSC::FIRST_OSC, SynthOSC::SECOND_OSC })
+        {
+            voice.setFineTune(osc, _fine_tunes[osc]);
+            voice.setUnisonDetune(osc, _unison_detunes[osc]);
+        }
+        voice.setPitchBend(_pitch_bend);
+    }
+    // The most copies either oscillator plays, as every voice does.
+    int getNumOfCopies() const noexcept
+    {
+        return juce::jmax(_unison[SynthOSC::FIRST_OSC], _unison[SynthOSC::SECOND_OSC]);
+    }
+    void rebuildVoiceLists()
+    {
+        _active_voices.clear();
+        _free_voices.clear();
+        _note_to_voice.fill(nullptr);
+        forEachVoice([this](auto& voice) {
+            voice->reset();
+            _free_voices.pushFront(voice.get());
+        });
+    }
+    void unmapNote(Voice* voice)
+    {
+        const auto note = voice->getCurrentNote();
+        if (note >= 0 && _note_to_voice[note] == voice)
+        {
+            _note_to_voice[note] = nullptr;
+        }
+    }
+    Voice* findVoiceToSteal()
+    {
+        switch (_steal_policy)
+        {
+            case (VoiceStealPolicy::QUIETEST):
+                return findBestVoice([](Voice* candidate, Voice* best) {
+                    return candidate->getLevel() < best->getLevel();
+                });
+            case (VoiceStealPolicy::LOWEST_STAGE):
+                // furthest along the envelope wins: release, then sustain, decay, attack
+                return findBestVoice([](Voice* candidate, Voice* best) {
+                    return candidate->getEnvelopeStage() > best->getEnvelopeStage();
+                });
+            case (VoiceStealPolicy::OLDEST):
+            case (VoiceStealPolicy::SAME_NOTE):
+            default:
+                return _active_voices.front();
+        }
+    }
+    template <typename IsBetter>
+    Voice* findBestVoice(IsBetter is_better)
+    {
+        // walks oldest first and only replaces on a strict improvement, so ties go to the oldest
+        Voice* best = _active_voices.front();
+        for (auto* candidate = best; candidate != nullptr; candidate = candidate->list_next)
+        {
+            if (is_better(candidate, best)) { best = candidate; }
+        }
+        return best;
+    }
+    void applyFilterSettings()
+    {
+        // only sounding voices recompute their coefficients, the rest do it at their next note
+        forEachVoice([this](auto& voice) { voice->setFilterSettings(_filter_settings); });
+    }
+    void onAmpADSRChange(ADSRStages stage, float value)
+    {
+        _amp_adsr[stage] = value;
+        forEachVoice([stage, value](auto& voice) { voice->setADSRParameter(stage, value); });
+    }
+    
+    //==============================================================================
+    void prepareBus (RenderBus& bus)
+    {
+        const auto max_block_size = static_cast<int>(_spec.juce_spec.maximumBlockSize);
+        bus.voice.setSize(2, _is_prepared ? max_block_size : 0, false, true, false);
+        bus.mix.setSize(2, _is_prepared ? max_block_size : 0, false, true, false);
+    }
+    
+    //==============================================================================
+    void processChunk (dsp::AudioBlock<BufferData>& outputBlock) noexcept
+    {
+        const auto num_samples = static_cast<int>(outputBlock.getNumSamples());
+        // the bank renders a single waveform per oscillator, crossfades need the per-voice path
+        const auto render_mode = (_wave_fade_left > 0) ? VoiceRenderMode::PER_VOICE : _render_mode.load();
+        _wave_fade_left = juce::jmax(0, _wave_fade_left - num_samples);
+        size_t num_of_voices = 0;
+        _active_voices.forEach([&](Voice* voice) { _render_voices[num_of_voices++] = voice; });
+        
+        // voices are rendered panned into a left/right mix, which is then
+        // spread over however many channels the output has
+        if (_worker_pool != nullptr && num_of_voices * VoiceBank::lanesPerVoice(getNumOfCopies()) >= MIN_LANES_FOR_WORKERS)
+        {
+            renderWithWorkers(num_of_voices, render_mode, num_samples);
+        } else
+        {
+            clearMix(_buses.front(), num_samples);
+            renderVoices(0, num_of_voices, render_mode, _buses.front(), num_samples);
+        }
+        mixToOutput(outputBlock);
+        
+        _active_voices.forEach([this](Voice* voice) {
+            if (!voice->isBusy()) // envelope finished, stop rendering it
+            {
+                unmapNote(voice);
+                _active_voices.remove(voice);
+                _free_voices.pushFront(voice);
+            }
+        });
+    }
+    void renderWithWorkers (size_t num_of_voices, VoiceRenderMode render_mode, int num_samples) noexcept
+    {
+        static_assert (LANES_PER_TASK % VoiceBank::Lanes::size() == 0, "tasks must not split a lane group");
+        jassert (_buses.size() == static_cast<size_t>(_worker_pool->getNumOfParticipants()));
+        // whole groups, see VoiceBank::voicesPerGroup(); a voice filling more than the task is one on its own
+        const auto voices_per_task = juce::jmax<size_t>(1, LANES_PER_TASK / VoiceBank::lanesPerVoice(getNumOfCopies()));
+        
+        // every participant mixes whole tasks into its own bus, summed into the first one afterwards
+        for (auto& bus : _buses)
+        {
+            clearMix(bus, num_samples);
+        }
+        auto task = [this, num_of_voices, voices_per_task, render_mode, num_samples](int participant, int task_index) {
+            const auto first = static_cast<size_t>(task_index) * voices_per_task;
+            renderVoices(first, juce::jmin(voices_per_task, num_of_voices - first), render_mode, _buses[static_cast<size_t>(participant)], num_samples);
+        };
+        _worker_pool->parallelFor(static_cast<int>((num_of_voices + voices_per_task - 1) / voices_per_task), task);
+        
+        auto& result = _buses.front().mix;
+        for (size_t bus = 1; bus < _buses.size(); ++bus)
+        {
+            for (int side = 0; side < 2; ++side)
+            {
+                juce::FloatVectorOperations::add(result.getWritePointer(side), _buses[bus].mix.getReadPointer(side), num_samples);
+            }
+        }
+    }
+    void renderVoices (size_t first, size_t num_of_voices, VoiceRenderMode render_mode, RenderBus& bus, int num_samples) noexcept
+    {
+        if (render_mode == VoiceRenderMode::SIMD_BANK)
+        {
+            _bank.render(_render_voices.data(), first, num_of_voices, getNumOfCopies(), _wave_types, _oscillator_mode, _filter_settings.enabled, _fm_index > 0.0f,
+                         {{ bus.mix.getWritePointer(0), bus.mix.getWritePointer(1) }}, num_samples);
+            return;
+        }
+        
+        auto voice_block = GetScratchBlock(bus.voice, 2, static_cast<size_t>(num_samples));
+        dsp::ProcessContextReplacing<BufferData> voice_context(voice_block);
+        for (size_t index = first; index < first + num_of_voices; ++index)
+        {
+            _render_voices[index]->process({ // voice overwrites the scratch block, no need to clear it
+                .juce_context = voice_context
+            });
+            for (int side = 0; side < 2; ++side)
+            {
+                juce::FloatVectorOperations::add(bus.mix.getWritePointer(side), voice_block.getChannelPointer(static_cast<size_t>(side)), num_samples);
+            }
+        }
+    }
+    static void clearMix (RenderBus& bus, int num_samples) noexcept
+    {
+        for (int side = 0; side < 2; ++side)
+        {
+            juce::FloatVectorOperations::clear(bus.mix.getWritePointer(side), num_samples);
+        }
+    }
+    void mixToOutput (dsp::AudioBlock<BufferData>& outputBlock) noexcept
+    {
+        const auto  num_samples  = static_cast<int>(outputBlock.getNumSamples());
+        const auto  num_channels = outputBlock.getNumChannels();
+        const auto* left         = _buses.front().mix.getReadPointer(0);
+        const auto* right        = _buses.front().mix.getReadPointer(1);
+        if (num_channels == 1)
+        {
+            auto* output = outputBlock.getChannelPointer(0);
+            juce::FloatVectorOperations::addWithMultiply(output, left,  0.5f, num_samples);
+            juce::FloatVectorOperations::addWithMultiply(output, right, 0.5f, num_samples);
+            return;
+        }
+        for (size_t channel = 0; channel < num_channels; ++channel) // wider layouts alternate left and right
+        {
+            juce::FloatVectorOperations::add(outputBlock.getChannelPointer(channel), (channel % 2 == 0) ? left : right, num_samples);
+        }
     }
-    void reset () noexcept
+    template <typename Callback>
+    void forEachVoice (Callback&& callback)
     {
-        _processorChain.reset();
+        for (auto& _voice : _voices)
+        {
+            callback(_voice);
+        }
     }
+
+};
+
+//==============================================================================
+/** A cloud of short, windowed grains read from the loaded Sample, mixed in
+    next to the voices while the density is above zero.
+
+    Grains live in a fixed pool of MAX_GRAINS that is kept dense: a new grain
+    goes after the last active one and a finished one is replaced by the
+    last, so starting, rendering and recycling them never allocates, locks or
+    searches for a free slot. A grain takes the settings as they are when it
+    starts and keeps them to its end; while the pool is full new grains are
+    skipped, not queued.
+
+    Grains render in groups, one per SIMD lane: their window gains come
+    from shared tables (see GrainWindow), written interleaved so a sample of
+    the whole group is one register, and the sample is read with the
+    interpolation chosen, see SampleReader. Mono samples are read once for
+    both sides. Memory-mapped samples are converted first, each lane the
+    stretch its grain covers, in runs short enough for those stretches to
+    fit into MAX_RUN_FRAMES.
     
+    Rendering is timed, see getLoad(), to budget large clouds.
+*/
+class GrainEngine : public IAudioProcessor
+{
+public:
     //==============================================================================
-    void noteOn (const juce::MidiMessage& midiMessage)
-    {
-        setCurrentNote(midiMessage.getNoteNumber());
-        getADSR().noteOn();
-        setFrequency(calculateFrequency(midiMessage.getMidiNoteInHertz(getCurrentNote())));
-        setGain(calculateGain(midiMessage.getVelocity()));
-    }
-    void noteOff ()
+    static constexpr int    MAX_GRAINS      = 1024;
+    static constexpr double REPORT_INTERVAL = 0.25; // seconds of audio the load is averaged over
+    static constexpr int    MAX_RUN_FRAMES  = 4096; // frames a lane converts from a mapped sample at once
+    static constexpr double SWAP_FADE       = 0.005; // seconds grains of a replaced sample fade out over
+    
+    using Lanes = SampleReader::Lanes;
+    static constexpr size_t NUM_LANES = SampleReader::NUM_LANES; // grains rendered side by side
+    
+    // Published by the audio thread, read from any other.
+    struct Load
     {
-        getADSR().noteOff();
-        _current_note = -1;
-    }
+        float active_grains = 0.0f; // on average
+        float cpu_per_grain = 0.0f; // share of one core's realtime budget a single grain takes
+    };
     
     //==============================================================================
-    void setWaveType(VoiceWaveType wave_type)
+    GrainEngine (IAudioProcessor::SynthStatePtr state_ptr): IAudioProcessor(state_ptr)
     {
-        switch(wave_type)
+        using namespace std::placeholders;
+        
+        for (auto param : { GrainParam::GRAIN_DENSITY, GrainParam::GRAIN_SIZE, GrainParam::GRAIN_POSITION, GrainParam::GRAIN_JITTER,
+                            GrainParam::GRAIN_PITCH, GrainParam::GRAIN_PAN, GrainParam::GRAIN_PAN_SPREAD, GrainParam::GRAIN_LEVEL,
+                            GrainParam::GRAIN_TAPER })
         {
-            case (VoiceWaveType::SIN):
-                getOSC().initialise(genSinWave, 128);
-                break;
-            case (VoiceWaveType::SAW):
-                getOSC().initialise(genSawWave, 128);
-                break;
+            setParam(param, getSynthState()->getGrainParam(param));
+            getSynthState()->onGrainParamChange(param, std::bind(&GrainEngine::setParam, this, param, _1));
         }
-        getOSC().reset();
+        
+        for (auto shape : { GrainWindowShape::HANN_WINDOW, GrainWindowShape::TUKEY_WINDOW, GrainWindowShape::GAUSSIAN_WINDOW,
+                            GrainWindowShape::TRAPEZOID_WINDOW, GrainWindowShape::EXPONENTIAL_WINDOW })
+        {
+            getSharedWindow(shape); // build the shared tables here, never on the audio thread
+        }
+        SampleReader::Sinc::getTaps(); // same
+        setInterpolation(getSynthState()->getGrainInterpolation());
+        getSynthState()->onGrainInterpolationChange(std::bind(&GrainEngine::setInterpolation, this, _1));
+        setWindow(getSynthState()->getGrainWindow());
+        getSynthState()->onGrainWindowChange(std::bind(&GrainEngine::setWindow, this, _1));
     }
-    void setFrequency(int frequency)
+    
+    //==============================================================================
+    void prepare (const IAudioProcessorConfig& spec) noexcept override
     {
-        getOSC().setFrequency(frequency, false);
+        _sample_rate = spec.juce_spec.sampleRate;
+        _mix.setSize(2, static_cast<int>(spec.juce_spec.maximumBlockSize), false, true, false);
+        _window_storage.allocate(spec.juce_spec.maximumBlockSize * NUM_LANES + NUM_LANES, true); // one spare register to align the start
+        _windows = Lanes::getNextSIMDAlignedPtr(_window_storage.get());
+        _frames.setSize(static_cast<int>(Sample::MAX_CHANNELS * NUM_LANES), MAX_RUN_FRAMES, false, true, false);
+        reset();
     }
-    void setGain(float gain)
+    // Adds the cloud to the output block.
+    void process (const IAudioProcessContext& context) noexcept override
     {
-        getGain().setGainLinear(gain);
+        auto& outputBlock = context.juce_context.getOutputBlock();
+        
+        // hosts may exceed the block size announced in prepare(), render in chunks then
+        const auto max_chunk = static_cast<size_t>(_mix.getNumSamples());
+        if (max_chunk == 0) return; // not prepared yet
+        const auto start_ticks = juce::Time::getHighResolutionTicks();
+        if (_sample != nullptr && (_num_active > 0 || _density > 0.0f))
+        {
+            for (size_t start = 0; start < outputBlock.getNumSamples(); start += max_chunk)
+            {
+                auto chunk = outputBlock.getSubBlock(start, juce::jmin(max_chunk, outputBlock.getNumSamples() - start));
+                processChunk(chunk);
+            }
+        }
+        measure(juce::Time::getHighResolutionTicks() - start_ticks, outputBlock.getNumSamples());
     }
-    void setTranspose(VoiceTranspose transpose)
+    void reset () noexcept override
     {
-        _transpose = transpose;
+        _num_active      = 0;
+        _spawn_countdown = 0.0;
+        _measured_ticks  = 0;
+        _measured_samples       = 0;
+        _measured_grain_samples = 0;
+        if (_swapping) finishSwap(); // nothing reads the old sample any more
     }
     
     //==============================================================================
-    bool isBusy ()
+    // Audio thread, between blocks. Grains playing from the sample it replaces
+    // fade out over SWAP_FADE instead of being cut, new grains start once they
+    // are done: keep that sample alive while isReadingReplacedSample().
+    void setSample (const Sample* sample) noexcept
     {
-        return (getADSR().isActive());
-    }
-    void setCurrentNote (int note_number)
-    {
-        _current_note = note_number;
+        if (sample == getSpawnSample()) return; // no-change
+        if (! _swapping)
+        {
+            const auto fade_length = juce::jmax(1, juce::roundToInt(SWAP_FADE * _sample_rate));
+            for (int index = 0; index < _num_active; ++index)
+            {
+                auto& grain = _grains[static_cast<size_t>(index)];
+                grain.samples_left = juce::jmin(grain.samples_left, fade_length);
+                grain.fade_length  = grain.samples_left;
+            }
+        }
+        _next_sample = sample;
+        _swapping    = true;
+        if (_num_active == 0) finishSwap();
     }
-    int getCurrentNote ()
+    bool isReadingReplacedSample () const noexcept
     {
-        return _current_note;
+        return _swapping;
     }
-    
-private:
-    //==============================================================================
-    using OSC            = juce::dsp::Oscillator<BufferData>;
-    using Gain           = juce::dsp::Gain<BufferData>;
-    using ProcessorChain = juce::dsp::ProcessorChain<OSC, ADSRProcessor, Gain>;
-    
-    //==============================================================================
-    ProcessorChain _processorChain;
-    int            _current_note = -1;
-    VoiceTranspose _transpose = VoiceTranspose::NO_TRANSPOSE;
-    
-    //==============================================================================
-    OSC& getOSC () noexcept
+    void setParam (GrainParam param, float value)
     {
-        return _processorChain.get<0>();
+        switch (param)
+        {
+            case GrainParam::GRAIN_DENSITY    : _density    = juce::jmax(0.0f, value); break;
+            case GrainParam::GRAIN_SIZE       : _size       = juce::jmax(0.0f, value); break;
+            case GrainParam::GRAIN_POSITION   : _position   = value; break;
+            case GrainParam::GRAIN_JITTER     : _jitter     = value; break;
+            case GrainParam::GRAIN_PITCH      : _pitch      = value; break;
+            case GrainParam::GRAIN_PAN        : _pan        = value; break;
+            case GrainParam::GRAIN_PAN_SPREAD : _pan_spread = value; break;
+            case GrainParam::GRAIN_LEVEL      : _level      = value; break;
+            case GrainParam::GRAIN_TAPER      : _taper      = value; break;
+        }
     }
-    ADSRProcessor& getADSR () noexcept
+    void setWindow (GrainWindowShape shape)
     {
-        return _processorChain.get<1>();
+        _window = getSharedWindow(shape); // grains already playing keep theirs
     }
-    Gain& getGain () noexcept
+    void setInterpolation (GrainInterpolation interpolation)
     {
-        return _processorChain.get<2>();
+        _interpolation = interpolation; // playing grains switch too, they read through it every sample
     }
-
-    //==============================================================================
-    BufferData static genSinWave (BufferData angle)
+    Load getLoad () const noexcept
     {
-        return std::sin(angle);
+        return { _active_grains.load(), _cpu_per_grain.load() };
     }
-    BufferData static genSawWave (BufferData angle)
+    // Audio thread: the frames of the sample grains starting now would read,
+    // from the lowest start the jitter reaches to a grain's span past the
+    // highest, the kernels' MARGIN and a mapped run's rounding included.
+    juce::Range<juce::int64> getUpcomingFrames () const noexcept
     {
-        return juce::jmap(angle,
-                          BufferData(-juce::MathConstants<double>::pi),
-                          BufferData(juce::MathConstants<double>::pi),
-                          BufferData(-1),
-                          BufferData(1));
+        const auto* sample = getSpawnSample();
+        if (sample == nullptr) return {};
+        const auto placement = getPlacement(*sample);
+        if (placement.length < 1) return {};
+        const auto first = placement.getStart(_position - _jitter);
+        const auto last  = placement.getStart(_position + _jitter);
+        return { static_cast<juce::int64>(first) - SampleReader::MARGIN,
+                 static_cast<juce::int64>(std::ceil(last + placement.getSpan())) + SampleReader::MARGIN + 2 };
     }
     
     //==============================================================================
-    int calculateFrequency (float note_freq)
+    static const GrainWindow* getSharedWindow (GrainWindowShape shape)
     {
-        switch (_transpose)
+        // tables are built on first use and shared by every instance
+        switch (shape)
         {
-            case VoiceTranspose::MINUS_TWO_OCTAVES : return note_freq / 4;
-            case VoiceTranspose::MINUS_ONE_OCTAVE  : return note_freq / 2;
-            case VoiceTranspose::NO_TRANSPOSE      : return note_freq;
-            case VoiceTranspose::PLUS_ONE_OCTAVE   : return note_freq * 2;
-            case VoiceTranspose::PLUS_TWO_OCTAVES  : return note_freq * 4;
+            case GrainWindowShape::HANN_WINDOW:
+            case GrainWindowShape::TUKEY_WINDOW:
+            {
+                static const GrainWindow hann([](double phase) {
+                    return 0.5 - 0.5 * std::cos(juce::MathConstants<double>::twoPi * phase);
+                });
+                static const GrainWindow tukey([](double phase) {
+                    return 0.5 - 0.5 * std::cos(juce::MathConstants<double>::twoPi * phase);
+                }, true);
+                return (shape == GrainWindowShape::HANN_WINDOW) ? &hann : &tukey;
+            }
+            case GrainWindowShape::GAUSSIAN_WINDOW:
+            {
+                // sigma of a sixth of the grain, lowered and rescaled so it starts and ends at 0
+                static const GrainWindow gaussian([](double phase) {
+                    const auto curve = [](double x) { return std::exp(-18.0 * (x - 0.5) * (x - 0.5)); };
+                    return (curve(phase) - curve(0.0)) / (1.0 - curve(0.0));
+                });
+                return &gaussian;
+            }
+            case GrainWindowShape::TRAPEZOID_WINDOW:
+            {
+                static const GrainWindow trapezoid([](double phase) {
+                    return 1.0 - std::abs(2.0 * phase - 1.0);
+                }, true);
+                return &trapezoid;
+            }
+            case GrainWindowShape::EXPONENTIAL_WINDOW:
+            {
+                // rises over the first 2%, decays by about 50 dB towards an end lowered to 0
+                static const GrainWindow exponential([](double phase) {
+                    const auto attack = std::sin(juce::MathConstants<double>::halfPi * juce::jmin(1.0, phase / 0.02));
+                    return attack * attack * (std::exp(-6.0 * phase) - std::exp(-6.0)) / (1.0 - std::exp(-6.0));
+                });
+                return &exponential;
+            }
         }
-    }
-    float calculateGain (float velocity)
-    {
-        return velocity / 127.0f * 0.05f;
+        return nullptr;
     }
     
+private:
     //==============================================================================
-    void onAttackChange (float attack)
-    {
-        getADSR().setParameter(ADSRStages::ATTACK, attack);
-    }
-    void onDecayChange (float decay)
+    struct Grain
     {
-        getADSR().setParameter(ADSRStages::DECAY, decay);
-    }
-    void onSustainChange (float sustain)
+        double             position;     // in frames of the sample
+        double             increment;    // frames of the sample per output sample
+        const GrainWindow* window;
+        float              window_phase; // 0 to 1 over the grain
+        float              window_step;
+        float              taper;
+        float              gain_left;
+        float              gain_right;
+        int                samples_left;
+        int                delay;        // into the block it starts in
+        int                fade_length;  // of the fade out to the end, 0 while not fading
+    };
+    
+    // Where in a sample grains of the current settings start and how they
+    // move through it. Every read stays SampleReader::MARGIN frames inside
+    // the sample, the position a finished grain rests at included.
+    struct Placement
     {
-        getADSR().setParameter(ADSRStages::SUSTAIN, sustain);
-    }
-    void onReleaseChange (float release)
+        double lowest;    // the first frame a grain may start at
+        double highest;   // the last one it may read at
+        double increment; // frames of the sample per output sample
+        int    length;    // output samples, none fit when below 1
+        
+        double getSpan () const noexcept
+        {
+            return length * increment;
+        }
+        // Grains around centre, 0 to 1 over the sample, end before highest.
+        double getStart (float centre) const noexcept
+        {
+            return juce::jlimit(lowest, highest - getSpan(), lowest + static_cast<double>(centre) * (highest - lowest));
+        }
+    };
+    
+    //==============================================================================
+    Placement getPlacement (const Sample& sample) const noexcept
     {
-        getADSR().setParameter(ADSRStages::RELEASE, release);
+        Placement placement;
+        placement.lowest    = static_cast<double>(SampleReader::MARGIN);
+        placement.highest   = static_cast<double>(sample.getNumSamples() - 1 - SampleReader::MARGIN);
+        placement.increment = std::exp2(_pitch / 12.0) * sample.getSampleRate() / _sample_rate;
+        // the whole grain has to fit into the sample, shorter ones keep their full window;
+        // none at all when it's too short to read from
+        placement.length    = (placement.highest > placement.lowest)
+                            ? juce::jmin(juce::roundToInt(_size * 0.001 * _sample_rate), static_cast<int>((placement.highest - placement.lowest) / placement.increment))
+                            : 0;
+        return placement;
     }
-};
-
-//==============================================================================
-class VoiceManager : public IAudioProcessor
-{
-public:
-    //==============================================================================
-    VoiceManager (IAudioProcessor::SynthStatePtr state_ptr): IAudioProcessor(state_ptr)
+    // The sample new grains start from.
+    const Sample* getSpawnSample () const noexcept
     {
-       for (VoiceNum i = 0; i < _NUM_OF_VOICES; i++)
-       {
-           _voices.add(std::make_shared<Voice>(state_ptr));
-       }
+        return _swapping ? _next_sample : _sample;
     }
-    ~VoiceManager ()
+    void finishSwap () noexcept
     {
-        reset();
-        _voices.clear();
+        _sample      = _next_sample;
+        _next_sample = nullptr;
+        _swapping    = false;
     }
     
     //==============================================================================
-    void prepare (const IAudioProcessorConfig &spec) noexcept override
+    void processChunk (dsp::AudioBlock<BufferData>& outputBlock) noexcept
     {
-        forEachVoice([&spec](auto voice) { voice->prepare(spec); });
+        const auto num_samples = static_cast<int>(outputBlock.getNumSamples());
+        auto* left  = _mix.getWritePointer(0);
+        auto* right = _mix.getWritePointer(1);
+        juce::FloatVectorOperations::clear(left,  num_samples);
+        juce::FloatVectorOperations::clear(right, num_samples);
+        
+        spawnGrains(num_samples);
+        for (int first = 0; first < _num_active; first += static_cast<int>(NUM_LANES))
+        {
+            switch (_interpolation)
+            {
+                case GrainInterpolation::LINEAR_INTERPOLATION  : renderGroup<SampleReader::Linear>(first, left, right, num_samples);  break;
+                case GrainInterpolation::HERMITE_INTERPOLATION : renderGroup<SampleReader::Hermite>(first, left, right, num_samples); break;
+                case GrainInterpolation::SINC_INTERPOLATION    : renderGroup<SampleReader::Sinc>(first, left, right, num_samples);    break;
+            }
+        }
+        for (int index = 0; index < _num_active;)
+        {
+            if (_grains[static_cast<size_t>(index)].samples_left > 0)
+            {
+                ++index;
+            } else
+            {
+                _grains[static_cast<size_t>(index)] = _grains[static_cast<size_t>(--_num_active)]; // the last one takes its slot
+            }
+        }
+        if (_swapping && _num_active == 0) finishSwap();
+        mixToOutput(outputBlock);
     }
-    void process (const IAudioProcessContext &context) noexcept override
+    void spawnGrains (int num_samples) noexcept
     {
-        forEachVoice([&context](auto voice) {
-            auto& outputBlock = context.juce_context.getOutputBlock(); // get output audio block
-            
-            juce::AudioBuffer<BufferData> buffer(outputBlock.getNumChannels(), outputBlock.getNumSamples()); // init empty buffer with same size
-            dsp::AudioBlock<BufferData> block(buffer); // init audio block from buffer
-            block.copyFrom(outputBlock); // copy output buffer to it
-            dsp::ProcessContextReplacing<BufferData> voice_context(block); // create context from it
-            voice->process({ // process it independently
-                .juce_context = voice_context
-            });
-            
-            outputBlock.replaceWithSumOf(voice_context.getOutputBlock(), outputBlock); // mix it with output
-        });
+        if (_density <= 0.0f)
+        {
+            _spawn_countdown = 0.0; // the first grain starts right away when the density comes back
+            return;
+        }
+        const auto interval = _sample_rate / _density;
+        auto next = _spawn_countdown;
+        for (; next < num_samples; next += interval)
+        {
+            if (_num_active < MAX_GRAINS && ! _swapping) // none start from a sample on its way out
+            {
+                startGrain(static_cast<int>(next));
+            }
+        }
+        _spawn_countdown = next - num_samples;
     }
-    void reset () noexcept override
+    void startGrain (int delay) noexcept
     {
-        forEachVoice([](auto voice) { voice->reset(); });
+        const auto placement = getPlacement(*_sample);
+        const auto length    = placement.length;
+        if (length < 1) return;
+        
+        const auto centre = _position + _jitter * (2.0f * _random.nextFloat() - 1.0f);
+        const auto gains  = Voice::calculatePanGains(_pan + _pan_spread * (2.0f * _random.nextFloat() - 1.0f));
+        // overlapping grains add up, keep the cloud about as loud at any density
+        const auto gain   = _level / std::sqrt(juce::jmax(1.0f, _density * _size * 0.001f));
+        
+        auto& grain = _grains[static_cast<size_t>(_num_active++)];
+        grain.position     = placement.getStart(centre);
+        grain.increment    = placement.increment;
+        grain.window       = _window;
+        grain.taper        = _taper;
+        grain.window_step  = 1.0f / static_cast<float>(length);
+        grain.window_phase = 0.5f * grain.window_step; // sample centres, the window is symmetric
+        grain.gain_left    = gain * gains[0];
+        grain.gain_right   = gain * gains[1];
+        grain.samples_left = length;
+        grain.fade_length  = 0;
+        grain.delay        = delay;
     }
-    
-    //==============================================================================
-    void noteOn (const juce::MidiMessage& midiMessage)
+    // Renders the grains from first on, as many as there are lanes, side by
+    // side. Lanes without a grain, or whose grain isn't playing at a sample,
+    // get no gain and read from where they rest.
+    template <typename Reader>
+    void renderGroup (int first, float* left, float* right, int num_samples) noexcept
     {
-        // try to play note using free voice
-        try {
-            findVoice([](auto voice) -> bool { return (!voice->isBusy()); })->noteOn(midiMessage);
-        } catch (std::runtime_error& no_free_voice_error) {
-            // steal voice if there are no free voices available
-            try {
-                findVoice([](auto voice) -> bool { return (voice->isBusy()); })->noteOn(midiMessage);
-            } catch (std::runtime_error& steal_voice_error) {
-                // something weird happened, do nothing
-                std::cerr << "Cannot steal voice!" << std::endl;
+        const auto num_lanes = juce::jmin(NUM_LANES, static_cast<size_t>(_num_active - first));
+        alignas (Lanes::SIMDRegisterSize) float gains_left[NUM_LANES]  = {};
+        alignas (Lanes::SIMDRegisterSize) float gains_right[NUM_LANES] = {};
+        std::array<double, NUM_LANES> positions;
+        std::array<double, NUM_LANES> increments;
+        std::array<int, NUM_LANES>    begins;
+        std::array<int, NUM_LANES>    ends;
+        positions.fill(SampleReader::MARGIN);
+        increments.fill(0.0);
+        begins.fill(0);
+        ends.fill(0);
+        
+        auto group_begin = num_samples;
+        auto group_end   = 0;
+        for (size_t lane = 0; lane < num_lanes; ++lane)
+        {
+            const auto& grain = _grains[static_cast<size_t>(first) + lane];
+            positions[lane]  = grain.position;
+            increments[lane] = grain.increment;
+            begins[lane]     = grain.delay;
+            ends[lane]       = grain.delay + juce::jmin(num_samples - grain.delay, grain.samples_left);
+            gains_left[lane]  = grain.gain_left;
+            gains_right[lane] = grain.gain_right;
+            group_begin = juce::jmin(group_begin, begins[lane]);
+            group_end   = juce::jmax(group_end, ends[lane]);
+        }
+        if (group_end <= group_begin) return;
+        
+        // window gains interleaved, one register per sample
+        juce::FloatVectorOperations::clear(_windows + static_cast<size_t>(group_begin) * NUM_LANES, (group_end - group_begin) * static_cast<int>(NUM_LANES));
+        for (size_t lane = 0; lane < num_lanes; ++lane)
+        {
+            const auto& grain = _grains[static_cast<size_t>(first) + lane];
+            auto* windows = _windows + static_cast<size_t>(begins[lane]) * NUM_LANES + lane;
+            grain.window->render(windows, ends[lane] - begins[lane], grain.window_phase, grain.window_step, grain.taper, static_cast<int>(NUM_LANES));
+            for (int sample = 0; grain.fade_length > 0 && sample < ends[lane] - begins[lane]; ++sample)
+            {
+                windows[static_cast<size_t>(sample) * NUM_LANES] *= static_cast<float>(grain.samples_left - sample) / static_cast<float>(grain.fade_length);
             }
         }
-    }
-    void noteOff (const juce::MidiMessage& midiMessage)
-    {
-        try {
-            findVoice([&midiMessage](auto voice) -> bool {
-                return (voice->isBusy() && voice->getCurrentNote() == midiMessage.getNoteNumber());
-            })->noteOff();
-        } catch (std::runtime_error& no_voice_playing_note_error) {
-            std::cerr << "Cannot find voice playing provided note!" << std::endl;
+        
+        const auto& audio     = _sample->getAudio();
+        const auto  is_stereo = _sample->getNumChannels() > 1;
+        std::array<const float*, NUM_LANES> sources_left;
+        std::array<const float*, NUM_LANES> sources_right;
+        std::array<int, NUM_LANES>          offsets; // the frame of the sample a lane's sources start at
+        offsets.fill(0);
+        if (! _sample->isMapped())
+        {
+            sources_left.fill(audio.getReadPointer(0));
+            sources_right.fill(audio.getReadPointer(is_stereo ? 1 : 0));
+        }
+        
+        const auto  gain_left    = Lanes::fromRawArray(gains_left);
+        const auto  gain_right   = Lanes::fromRawArray(gains_right);
+        const auto  run_length   = _sample->isMapped() ? getMappedRunLength(increments) : group_end - group_begin;
+        SampleReader::Points<Reader::NUM_POINTS> points_left;
+        SampleReader::Points<Reader::NUM_POINTS> points_right;
+        for (int run = group_begin; run < group_end; run += run_length)
+        {
+            const auto run_end = juce::jmin(group_end, run + run_length);
+            if (_sample->isMapped())
+            {
+                convertRun(positions, increments, begins, ends, run, run_end, sources_left, sources_right, offsets);
+            }
+            for (int sample = run; sample < run_end; ++sample)
+            {
+                for (size_t lane = 0; lane < NUM_LANES; ++lane)
+                {
+                    const auto index    = static_cast<int>(positions[lane]);
+                    const auto fraction = static_cast<float>(positions[lane] - index);
+                    points_left.gather(lane, sources_left[lane], index - offsets[lane], Reader::FIRST, fraction);
+                    if (is_stereo)
+                    {
+                        points_right.gather(lane, sources_right[lane], index - offsets[lane], Reader::FIRST, fraction);
+                    }
+                    if (sample >= begins[lane] && sample < ends[lane])
+                    {
+                        positions[lane] += increments[lane];
+                    }
+                }
+                const auto window      = Lanes::fromRawArray(_windows + static_cast<size_t>(sample) * NUM_LANES);
+                const auto value_left  = Reader::interpolate(points_left) * window;
+                const auto value_right = is_stereo ? Reader::interpolate(points_right) * window : value_left; // mono samples are read once
+                left[sample]  += (value_left  * gain_left).sum();
+                right[sample] += (value_right * gain_right).sum();
+            }
+        }
+        
+        for (size_t lane = 0; lane < num_lanes; ++lane)
+        {
+            auto& grain = _grains[static_cast<size_t>(first) + lane];
+            const auto count = ends[lane] - begins[lane];
+            grain.position      = positions[lane];
+            grain.window_phase += static_cast<float>(count) * grain.window_step;
+            grain.samples_left -= count;
+            grain.delay         = 0;
+            _measured_grain_samples += count;
         }
     }
-    void setTranspose(VoiceTranspose transpose)
+    // Output samples a run may take for the fastest lane's stretch of a
+    // mapped sample to fit, see convertRun().
+    static int getMappedRunLength (const std::array<double, NUM_LANES>& increments) noexcept
     {
-        forEachVoice([&transpose](auto voice) {
-            voice->setTranspose(transpose);
-        });
+        const auto fastest = *std::max_element(increments.begin(), increments.end());
+        const auto room    = MAX_RUN_FRAMES - 2 * SampleReader::MARGIN - 2;
+        return (fastest > 0.0) ? juce::jmax(1, static_cast<int>(room / fastest)) : room;
     }
-    void setWaveType(VoiceWaveType wave_type)
+    // Converts the frames each lane reads in the output samples [run,
+    // run_end) from the mapped sample, and points the lane's sources there.
+    void convertRun (const std::array<double, NUM_LANES>& positions, const std::array<double, NUM_LANES>& increments,
+                     const std::array<int, NUM_LANES>& begins, const std::array<int, NUM_LANES>& ends, int run, int run_end,
+                     std::array<const float*, NUM_LANES>& sources_left, std::array<const float*, NUM_LANES>& sources_right,
+                     std::array<int, NUM_LANES>& offsets) noexcept
     {
-        forEachVoice([&wave_type](auto voice) { voice->setWaveType(wave_type); });
+        const auto is_stereo = _sample->getNumChannels() > 1;
+        for (size_t lane = 0; lane < NUM_LANES; ++lane)
+        {
+            // a lane reads up to MARGIN frames either side of the frames it
+            // passes, and one more for the rounding of its positions
+            const auto steps     = juce::jmax(0, juce::jmin(run_end, ends[lane]) - juce::jmax(run, begins[lane]));
+            const auto start     = static_cast<int>(positions[lane]) - SampleReader::MARGIN;
+            const auto available = _sample->getNumSamples() - start;
+            const auto length    = juce::jmin(available, static_cast<int>(std::ceil(steps * increments[lane])) + 2 * SampleReader::MARGIN + 2);
+            jassert (start >= 0 && length <= MAX_RUN_FRAMES);
+            
+            float* const destination[] = { _frames.getWritePointer(static_cast<int>(2 * lane)), _frames.getWritePointer(static_cast<int>(2 * lane + 1)) };
+            _sample->readFrames(destination, start, length);
+            sources_left[lane]  = destination[0];
+            sources_right[lane] = destination[is_stereo ? 1 : 0];
+            offsets[lane]       = start;
+        }
     }
-    
-private:
-    //==============================================================================
-    using VoiceNum = unsigned int;
-    using VoicePtr = std::shared_ptr<Voice>;
-    using VoiceCallback = std::function<void(VoicePtr)>;
-    using VoicePredicate = std::function<bool(VoicePtr)>;
-    
-    //==============================================================================
-    const VoiceNum        _NUM_OF_VOICES = 4;
-    juce::Array<VoicePtr> _voices;
-    
-    //==============================================================================
-    void forEachVoice (VoiceCallback callback)
+    void mixToOutput (dsp::AudioBlock<BufferData>& outputBlock) noexcept
     {
-        for (auto _voice : _voices)
+        const auto  num_samples  = static_cast<int>(outputBlock.getNumSamples());
+        const auto  num_channels = outputBlock.getNumChannels();
+        const auto* left         = _mix.getReadPointer(0);
+        const auto* right        = _mix.getReadPointer(1);
+        if (num_channels == 1)
         {
-            callback(_voice);
+            auto* output = outputBlock.getChannelPointer(0);
+            juce::FloatVectorOperations::addWithMultiply(output, left,  0.5f, num_samples);
+            juce::FloatVectorOperations::addWithMultiply(output, right, 0.5f, num_samples);
+            return;
+        }
+        for (size_t channel = 0; channel < num_channels; ++channel) // wider layouts alternate left and right
+        {
+            juce::FloatVectorOperations::add(outputBlock.getChannelPointer(channel), (channel % 2 == 0) ? left : right, num_samples);
         }
     }
-    VoicePtr findVoice (VoicePredicate predicate)
+    // The time spent here, spawning and mixing included, over the time all
+    // grains together played for.
+    void measure (juce::int64 ticks, size_t num_samples) noexcept
     {
-        for (auto _voice : _voices)
+        _measured_ticks   += ticks;
+        _measured_samples += static_cast<juce::int64>(num_samples);
+        if (_measured_samples < static_cast<juce::int64>(REPORT_INTERVAL * _sample_rate)) return;
+        
+        _active_grains.store(static_cast<float>(_measured_grain_samples) / static_cast<float>(_measured_samples));
+        if (_measured_grain_samples > 0)
         {
-            if (predicate(_voice)) {
-                return _voice;
-            }
+            const auto grain_seconds = static_cast<double>(_measured_grain_samples) / _sample_rate;
+            _cpu_per_grain.store(static_cast<float>(juce::Time::highResolutionTicksToSeconds(_measured_ticks) / grain_seconds));
         }
-        throw std::runtime_error("Cannot find voice");
+        _measured_ticks         = 0;
+        _measured_samples       = 0;
+        _measured_grain_samples = 0;
     }
+    
+    //==============================================================================
+    std::array<Grain, MAX_GRAINS> _grains;
+    int                           _num_active = 0;
+    const Sample*                 _sample      = nullptr; // the one the playing grains read
+    const Sample*                 _next_sample = nullptr; // new grains' once the old ones faded out
+    bool                          _swapping    = false;
+    juce::AudioBuffer<BufferData> _mix; // left and right, the size of a block
+    juce::HeapBlock<float>        _window_storage;
+    float*                        _windows = nullptr; // aligned, NUM_LANES gains per sample of a block
+    juce::AudioBuffer<float>      _frames;            // two channels a lane, converted from mapped samples
+    const GrainWindow*            _window = nullptr;
+    GrainInterpolation            _interpolation = GrainInterpolation::HERMITE_INTERPOLATION;
+    juce::Random                  _random;
+    double                        _sample_rate     = 44100.0;
+    double                        _spawn_countdown = 0.0; // samples until the next grain starts
+    
+    float _density    = 0.0f;
+    float _size       = 80.0f;
+    float _position   = 0.0f;
+    float _jitter     = 0.0f;
+    float _pitch      = 0.0f;
+    float _pan        = 0.0f;
+    float _pan_spread = 0.0f;
+    float _level      = 0.5f;
+    float _taper      = 0.5f;
+    
+    juce::int64        _measured_ticks         = 0;
+    juce::int64        _measured_samples       = 0;
+    juce::int64        _measured_grain_samples = 0;
+    std::atomic<float> _active_grains { 0.0f };
+    std::atomic<float> _cpu_per_grain { 0.0f };
 };
 
 //==============================================================================
@@ -842,92 +4219,238 @@ private:
 class Synthesizer: public IAudioProcessor
 {
 public:
+    //==============================================================================
+    // events are applied on a grid of this many samples of running time, early
+    // by less than that, so where they land doesn't depend on the host's blocks
+    static constexpr size_t MIN_SUB_BLOCK_SIZE = 32;
+    // oversampling goes by powers of two, up to 8x
+    static constexpr unsigned int MAX_OVERSAMPLING_ORDER = 3;
+    
+    //==============================================================================
     Synthesizer (IAudioProcessor::SynthStatePtr state_ptr):
         IAudioProcessor(state_ptr),
-        _voiceManager_1(state_ptr),
-        _voiceManager_2(state_ptr),
+        _voiceManager(state_ptr),
+        _grainEngine(state_ptr),
         _filter(state_ptr)
     {
         using namespace std::placeholders;
         
-        _voiceManager_1.setWaveType(state_ptr->getWaveType(SynthOSC::FIRST_OSC));
-        getSynthState()->onWaveTypeChange(SynthOSC::FIRST_OSC,  std::bind(&Synthesizer::onOSC1WaveTypeChange, this, _1));
-        
-        _voiceManager_1.setTranspose(state_ptr->getTranspose(SynthOSC::FIRST_OSC));
-        getSynthState()->onTransposeChnge(SynthOSC::FIRST_OSC,  std::bind(&Synthesizer::onOSC1TransposeChange, this, _1));
-        
-        _voiceManager_2.setWaveType(state_ptr->getWaveType(SynthOSC::SECOND_OSC));
-        getSynthState()->onWaveTypeChange(SynthOSC::SECOND_OSC, std::bind(&Synthesizer::onOSC2WaveTypeChange, this, _1));
+        // every voice plays both oscillators, the manager forwards per-oscillator settings
+        for (auto osc : { SynthOSC::FIRST_OSC, SynthOSC::SECOND_OSC })
+        {
+            _voiceManager.setWaveType(osc, state_ptr->getWaveType(osc));
+            getSynthState()->onWaveTypeChange(osc, std::bind(&VoiceManager::setWaveType, &_voiceManager, osc, _1));
+            
+            _voiceManager.setTranspose(osc, state_ptr->getTranspose(osc));
+            getSynthState()->onTransposeChnge(osc, std::bind(&VoiceManager::setTranspose, &_voiceManager, osc, _1));
+        }
         
-        _voiceManager_2.setTranspose(state_ptr->getTranspose(SynthOSC::SECOND_OSC));
-        getSynthState()->onTransposeChnge(SynthOSC::SECOND_OSC, std::bind(&Synthesizer::onOSC2TransposeChange, this, _1));
+        setFilterMode(state_ptr->getFilterMode());
+        getSynthState()->onFilterModeChange(std::bind(&Synthesizer::setFilterMode, this, _1));
     };
     
     //==============================================================================
+    // Voices, grains and filter run at the oversampled rate, on blocks as much longer.
     void prepare (const IAudioProcessorConfig &spec) noexcept override
     {
-        _voiceManager_1.prepare(spec);
-        _voiceManager_2.prepare(spec);
-        _filter.prepare(spec);
+        auto oversampled_spec = spec;
+        _oversampling.reset();
+        if (_oversampling_order > 0)
+        {
+            _oversampling = std::make_unique<Oversampling>(spec.juce_spec.numChannels, _oversampling_order,
+                                                           Oversampling::filterHalfBandPolyphaseIIR);
+            _oversampling->initProcessing(spec.juce_spec.maximumBlockSize);
+            oversampled_spec.juce_spec.sampleRate       *= getOversamplingFactor();
+            oversampled_spec.juce_spec.maximumBlockSize *= static_cast<juce::uint32>(getOversamplingFactor());
+        }
+        _voiceManager.prepare(oversampled_spec);
+        _grainEngine.prepare(oversampled_spec);
+        _filter.prepare(oversampled_spec);
+        _rendered_samples = 0;
     }
     void process (const IAudioProcessContext &context) noexcept override
     {
-        _voiceManager_1.process(context);
-        processVoiceParalell(_voiceManager_2, context);
-        _filter.process(context);
+        _voiceManager.process(context); // accumulates into the output block
+        _grainEngine.process(context);  // so does the cloud
+        if (_filter_mode == FilterMode::GLOBAL_FILTER) // otherwise every voice runs its own
+        {
+            _filter.process(context);
+        }
     }
     void reset () noexcept override
     {
-        _voiceManager_1.reset();
-        _voiceManager_2.reset();
+        _voiceManager.reset();
+        _grainEngine.reset();
         _filter.reset();
+        if (_oversampling != nullptr)
+        {
+            _oversampling->reset();
+        }
+        _rendered_samples = 0;
     }
     
     //==============================================================================
     void noteOn (const juce::MidiMessage& midiMessage)
     {
-        _voiceManager_1.noteOn(midiMessage);
-        _voiceManager_2.noteOn(midiMessage);
+        _voiceManager.noteOn(midiMessage);
     }
     void noteOff (const juce::MidiMessage& midiMessage)
     {
-        _voiceManager_1.noteOff(midiMessage);
-        _voiceManager_2.noteOff(midiMessage);
+        _voiceManager.noteOff(midiMessage);
+    }
+    void handleMidiEvent (const juce::MidiMessage& midiMessage)
+    {
+        if (midiMessage.isNoteOn())
+        {
+            noteOn(midiMessage);
+        } else if (midiMessage.isNoteOff())
+        {
+            noteOff(midiMessage);
+        } else if (midiMessage.isPitchWheel())
+        {
+            _voiceManager.pitchWheelMoved(midiMessage.getPitchWheelValue());
+        }
     }
     
-private:
-    VoiceManager _voiceManager_1;
-    VoiceManager _voiceManager_2;
-    SynthFilter  _filter;
+    //==============================================================================
+    // Splits the block at the event positions, so notes start and stop on the
+    // sample they were sent for instead of at the start of the block. When
+    // oversampling, the voices render into the oversampler's buffer and the
+    // result is filtered back down into the block.
+    void renderNextBlock (const IAudioProcessContext &context, const juce::MidiBuffer& midiMessages) noexcept
+    {
+        auto& block = context.juce_context.getOutputBlock();
+        if (_oversampling == nullptr)
+        {
+            renderEvents(block, midiMessages, 1);
+            return;
+        }
+        // the block is silent, going up only hands out the oversampled buffer
+        // (and keeps the up filters' state consistent)
+        auto oversampled_block = _oversampling->processSamplesUp(block);
+        renderEvents(oversampled_block, midiMessages, getOversamplingFactor());
+        _oversampling->processSamplesDown(block);
+    }
     
     //==============================================================================
-    void processVoiceParalell(VoiceManager& voice_manager, const IAudioProcessContext &context)
+    // Takes effect on the next prepare(), which sizes everything for it.
+    void setOversamplingOrder (unsigned int order)
     {
-        auto& outputBlock = context.juce_context.getOutputBlock(); // get output audio block
-        juce::AudioBuffer<BufferData> buffer(outputBlock.getNumChannels(), outputBlock.getNumSamples()); // init empty buffer with same size
-        dsp::AudioBlock<BufferData> block(buffer); // init audio block from buffer
-        block.copyFrom(outputBlock); // copy output buffer to it
-        dsp::ProcessContextReplacing<BufferData> voice_context(block); // create context from it
-        voice_manager.process(context);
-        outputBlock.replaceWithSumOf(voice_context.getOutputBlock(), outputBlock); // mix it with output
+        _oversampling_order = juce::jmin(order, MAX_OVERSAMPLING_ORDER);
+    }
+    size_t getOversamplingFactor () const
+    {
+        return static_cast<size_t>(1) << _oversampling_order;
+    }
+    // In samples at the host rate, rounded: the polyphase filters' delay isn't whole.
+    int getLatencyInSamples () const
+    {
+        return (_oversampling != nullptr) ? juce::roundToInt(_oversampling->getLatencyInSamples()) : 0;
     }
     
     //==============================================================================
-    void onOSC1TransposeChange(VoiceTranspose transpose)
+    void setNumOfVoices (VoiceManager::VoiceNum num_of_voices)
+    {
+        _voiceManager.setNumOfVoices(num_of_voices);
+    }
+    void setNumOfRenderThreads (unsigned int num_of_threads)
+    {
+        _voiceManager.setNumOfRenderThreads(num_of_threads);
+    }
+    VoiceManager::VoiceNum getNumOfActiveVoices () const
+    {
+        return _voiceManager.getNumOfActiveVoices();
+    }
+    void setUserWavetable (const UserWavetable* table)
+    {
+        _voiceManager.setUserWavetable(table);
+    }
+    // Audio thread, between blocks; null until a file was loaded. The one it
+    // replaces has to stay alive while isReadingReplacedSample().
+    void setSample (const Sample* sample)
+    {
+        _sample = sample;
+        _grainEngine.setSample(sample);
+    }
+    const Sample* getSample () const noexcept
+    {
+        return _sample;
+    }
+    // Any thread, updated a few times a second while the synth plays.
+    GrainEngine::Load getGrainLoad () const noexcept
+    {
+        return _grainEngine.getLoad();
+    }
+    // Audio thread: the last sample replaced still has grains fading out.
+    bool isReadingReplacedSample () const noexcept
+    {
+        return _grainEngine.isReadingReplacedSample();
+    }
+    // Audio thread, see GrainEngine::getUpcomingFrames().
+    juce::Range<juce::int64> getUpcomingGrainFrames () const noexcept
     {
-        _voiceManager_1.setTranspose(transpose);
+        return _grainEngine.getUpcomingFrames();
     }
-    void onOSC1WaveTypeChange(VoiceWaveType wave_type)
+    void setFilterMode (FilterMode filter_mode)
     {
-        _voiceManager_1.setWaveType(wave_type);
+        if (filter_mode == FilterMode::GLOBAL_FILTER && _filter_mode != filter_mode)
+        {
+            _filter.reset(); // don't resume from whatever it held when it was switched off
+        }
+        _filter_mode = filter_mode;
     }
-    void onOSC2TransposeChange(VoiceTranspose transpose)
+    
+private:
+    //==============================================================================
+    using Oversampling = juce::dsp::Oversampling<BufferData>;
+    
+    //==============================================================================
+    VoiceManager _voiceManager;
+    GrainEngine  _grainEngine;
+    SynthFilter  _filter;
+    FilterMode   _filter_mode = FilterMode::GLOBAL_FILTER;
+    unsigned int _oversampling_order = 0;
+    std::unique_ptr<Oversampling> _oversampling;
+    const Sample* _sample = nullptr; // kept alive by the processor's RealtimeSwap
+    juce::uint64  _rendered_samples = 0; // at the block's rate, for the event grid
+    
+    //==============================================================================
+    // Event positions are host samples, factor scales them to the block's rate.
+    // An event splits the block on the last grid line before it, counted from
+    // prepare(), or is applied at the start when that line is in an earlier
+    // block: the same events then render the same whatever the host's block
+    // sizes, as long as they are multiples of the grid.
+    void renderEvents (dsp::AudioBlock<BufferData>& block, const juce::MidiBuffer& midiMessages, size_t factor) noexcept
     {
-        _voiceManager_2.setTranspose(transpose);
+        const auto num_samples = block.getNumSamples();
+        const auto grid        = MIN_SUB_BLOCK_SIZE * factor; // the same time as without oversampling
+        const auto block_start = _rendered_samples;
+        size_t start = 0;
+        for (const auto metadata : midiMessages)
+        {
+            const auto position   = juce::jmin(num_samples, static_cast<size_t>(juce::jmax(0, metadata.samplePosition)) * factor);
+            const auto grid_line  = (block_start + position) / grid * grid;
+            const auto split      = (grid_line > block_start) ? static_cast<size_t>(grid_line - block_start) : 0;
+            if (split > start)
+            {
+                renderSubBlock(block, start, split - start);
+                start = split;
+            }
+            handleMidiEvent(metadata.getMessage());
+        }
+        if (start < num_samples)
+        {
+            renderSubBlock(block, start, num_samples - start);
+        }
+        _rendered_samples += num_samples;
     }
-    void onOSC2WaveTypeChange(VoiceWaveType wave_type)
+    void renderSubBlock (dsp::AudioBlock<BufferData>& block, size_t start, size_t num_samples) noexcept
     {
-        _voiceManager_2.setWaveType(wave_type);
+        auto sub_block = block.getSubBlock(start, num_samples);
+        dsp::ProcessContextReplacing<BufferData> sub_context(sub_block);
+        process({
+            .juce_context = sub_context
+        });
     }
 };
 
@@ -986,6 +4509,7 @@ public:
     //==============================================================================
     void prepareToPlay (double sampleRate, int samplesPerBlock) override;
     void releaseResources () override;
+    void setNonRealtime (bool isNonRealtime) noexcept override;
 
    #ifndef JucePlugin_PreferredChannelConfigurations
     bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
@@ -1044,6 +4568,15 @@ public:
         if (waveform == "sin")
         {
             return 0;
+        } else if (waveform == "square")
+        {
+            return 2;
+        } else if (waveform == "triangle")
+        {
+            return 3;
+        } else if (waveform == "user")
+        {
+            return 4;
         } else {
             return 1;
         }
@@ -1069,6 +4602,21 @@ public:
         *filter_cutoff = cutoff;
     }
     
+    //==============================================================================
+    void setNumOfVoices(unsigned int num_of_voices);
+    void setNumOfRenderThreads(unsigned int num_of_threads);
+    // orders as powers of two, 0 to Synthesizer::MAX_OVERSAMPLING_ORDER; the
+    // offline one is used while the host renders faster than realtime
+    void setOversampling(unsigned int realtime_order, unsigned int offline_order);
+    void setVoiceRenderMode(VoiceRenderMode render_mode);
+    // Decoded and built in the background, OSC waveform "User" plays it.
+    void loadWavetable(const juce::File& file);
+    // Decoded in the background, replaces the sample once it's complete.
+    void loadSample(const juce::File& file);
+    bool canLoadSample(const juce::File& file) const;
+    // CPU use of the grain cloud, any thread.
+    GrainEngine::Load getGrainLoad() const;
+    
     
 private:
     //==============================================================================
@@ -1080,14 +4628,48 @@ private:
     //==============================================================================
     SynthesizerStatePtr         synthesizerState;
     Synthesizer                 synthesizer;
+    RealtimeSwap<UserWavetable> userWavetables;
+    WavetableLoader             wavetableLoader { userWavetables };
+    RealtimeSwap<Sample::Ptr>   samples;
+    SampleLoader                sampleLoader { samples };
     juce::AudioParameterChoice* osc_1_transpose;
     juce::AudioParameterChoice* osc_2_transpose;
     juce::AudioParameterChoice* osc_1_wave;
     juce::AudioParameterChoice* osc_2_wave;
+    juce::AudioParameterFloat*  wave_crossfade;
+    juce::AudioParameterChoice* osc_mode;
+    juce::AudioParameterFloat*  osc_1_fine;
+    juce::AudioParameterFloat*  osc_2_fine;
+    juce::AudioParameterFloat*  glide_time;
+    juce::AudioParameterInt*    osc_1_unison_voices;
+    juce::AudioParameterInt*    osc_2_unison_voices;
+    juce::AudioParameterFloat*  osc_1_unison_detune;
+    juce::AudioParameterFloat*  osc_2_unison_detune;
+    juce::AudioParameterFloat*  osc_1_unison_spread;
+    juce::AudioParameterFloat*  osc_2_unison_spread;
+    juce::AudioParameterFloat*  fm_index;
+    juce::AudioParameterFloat*  wavetable_position;
+    juce::AudioParameterFloat*  pulse_width;
     juce::AudioParameterFloat*  amp_attack;
     juce::AudioParameterFloat*  amp_decay;
     juce::AudioParameterFloat*  amp_sustain;
     juce::AudioParameterFloat*  amp_release;
+    juce::AudioParameterFloat*  amp_pan;
     juce::AudioParameterFloat*  filter_cutoff;
     juce::AudioParameterFloat*  filter_q;
+    juce::AudioParameterChoice* filter_mode;
+    juce::AudioParameterFloat*  filter_key_tracking;
+    juce::AudioParameterFloat*  filter_velocity;
+    juce::AudioParameterChoice* voice_steal;
+    juce::AudioParameterFloat*  grain_density;
+    juce::AudioParameterFloat*  grain_size;
+    juce::AudioParameterFloat*  grain_position;
+    juce::AudioParameterFloat*  grain_jitter;
+    juce::AudioParameterFloat*  grain_pitch;
+    juce::AudioParameterFloat*  grain_pan;
+    juce::AudioParameterFloat*  grain_pan_spread;
+    juce::AudioParameterFloat*  grain_level;
+    juce::AudioParameterChoice* grain_window;
+    juce::AudioParameterFloat*  grain_taper;
+    juce::AudioParameterChoice* grain_interpolation;
 };
@@ -0,0 +1,145 @@
+/*
+  ==============================================================================
+
+    PolyBLEP.h
+    Table-free band-limited saw, pulse and triangle kernels.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/** Naive waveforms with two-sample polynomial corrections around their
+    discontinuities: PolyBLEP for the steps of the saw and the pulse, PolyBLAMP
+    for the corners of the triangle. Nothing is stored, the cost is a handful of
+    multiplies per sample, which keeps the whole oscillator in registers.
+
+    Phases are normalised to [0, 1), increments are in cycles per sample. Every
+    kernel has a scalar version for Voice and one over SIMD lanes for VoiceBank,
+    computing the same polynomials; the lane versions take the reciprocal of
+    the increment since SIMDRegister can't divide. Phases line up with the
+    shared Wavetable shapes, so either can replace the other mid-note.
+*/
+class PolyBLEP
+{
+public:
+    //==============================================================================
+    using Lanes = juce::dsp::SIMDRegister<float>;
+
+    //==============================================================================
+    // Ramp from -1 to 1, dropping back at phase 0.
+    static float saw (float phase, float increment) noexcept
+    {
+        return 2.0f * phase - 1.0f - step(phase, increment);
+    }
+    // High for the first width of the cycle, without DC for any width.
+    static float pulse (float phase, float increment, float width) noexcept
+    {
+        const auto naive = ((phase < width) ? 1.0f : -1.0f) - (2.0f * width - 1.0f);
+        return naive + step(phase, increment) - step(wrap(phase - width + 1.0f), increment);
+    }
+    // Sine phase: 0 at phase 0, peaks at a quarter and three quarters.
+    static float triangle (float phase, float increment) noexcept
+    {
+        const auto naive = (phase < 0.25f) ? 4.0f * phase
+                         : (phase < 0.75f) ? 2.0f - 4.0f * phase
+                         :                   4.0f * phase - 4.0f;
+        const auto slope_change = 8.0f * increment; // per sample, at each corner
+        return naive - slope_change * corner(wrap(phase + 0.75f), increment)
+                     + slope_change * corner(wrap(phase + 0.25f), increment);
+    }
+
+    //==============================================================================
+    static Lanes saw (Lanes phase, Lanes increment, Lanes inv_increment) noexcept
+    {
+        const auto one = Lanes::expand(1.0f);
+        return phase + phase - one - step(phase, increment, inv_increment);
+    }
+    static Lanes pulse (Lanes phase, Lanes increment, Lanes inv_increment, Lanes width) noexcept
+    {
+        const auto one   = Lanes::expand(1.0f);
+        const auto high  = one - (width + width - one);
+        const auto naive = (high & Lanes::lessThan(phase, width)) + ((high - one - one) & Lanes::greaterThanOrEqual(phase, width));
+        return naive + step(phase, increment, inv_increment) - step(wrap(phase + (one - width)), increment, inv_increment);
+    }
+    static Lanes triangle (Lanes phase, Lanes increment, Lanes inv_increment) noexcept
+    {
+        const auto quarter = Lanes::expand(0.25f);
+        const auto four    = Lanes::expand(4.0f);
+        const auto rising  = Lanes::lessThan(phase, quarter);
+        const auto falling = Lanes::lessThan(phase, Lanes::expand(0.75f)) & ~rising;
+        const auto naive   = ((phase * four) & rising)
+                           + ((Lanes::expand(2.0f) - phase * four) & falling)
+                           + ((phase * four - four) & Lanes::greaterThanOrEqual(phase, Lanes::expand(0.75f)));
+        const auto slope_change = increment * Lanes::expand(8.0f);
+        return naive - slope_change * corner(wrap(phase + Lanes::expand(0.75f)), increment, inv_increment)
+                     + slope_change * corner(wrap(phase + quarter), increment, inv_increment);
+    }
+
+private:
+    //==============================================================================
+    // Correction for a step of -2 at phase 0, the saw's, over the samples on
+    // either side of it.
+    static float step (float phase, float increment) noexcept
+    {
+        auto correction = 0.0f;
+        if (phase < increment)
+        {
+            const auto x = phase / increment;
+            correction += x + x - x * x - 1.0f;
+        }
+        if (phase > 1.0f - increment)
+        {
+            const auto x = (phase - 1.0f) / increment;
+            correction += x * x + x + x + 1.0f;
+        }
+        return correction;
+    }
+    // Correction for a corner at phase 0 where the slope rises by one per sample.
+    static float corner (float phase, float increment) noexcept
+    {
+        auto correction = 0.0f;
+        if (phase < increment)
+        {
+            const auto x = 1.0f - phase / increment;
+            correction += x * x * x / 6.0f;
+        }
+        if (phase > 1.0f - increment)
+        {
+            const auto x = 1.0f + (phase - 1.0f) / increment;
+            correction += x * x * x / 6.0f;
+        }
+        return correction;
+    }
+    static float wrap (float phase) noexcept
+    {
+        return (phase >= 1.0f) ? phase - 1.0f : phase;
+    }
+
+    //==============================================================================
+    static Lanes step (Lanes phase, Lanes increment, Lanes inv_increment) noexcept
+    {
+        const auto one   = Lanes::expand(1.0f);
+        const auto after = phase * inv_increment;
+        const auto before = (phase - one) * inv_increment;
+        return ((after + after - after * after - one) & Lanes::lessThan(phase, increment))
+             + ((before * before + before + before + one) & Lanes::greaterThan(phase, one - increment));
+    }
+    static Lanes corner (Lanes phase, Lanes increment, Lanes inv_increment) noexcept
+    {
+        const auto one    = Lanes::expand(1.0f);
+        const auto sixth  = Lanes::expand(1.0f / 6.0f);
+        const auto after  = one - phase * inv_increment;
+        const auto before = one + (phase - one) * inv_increment;
+        return ((after * after * after * sixth) & Lanes::lessThan(phase, increment))
+             + ((before * before * before * sixth) & Lanes::greaterThan(phase, one - increment));
+    }
+    static Lanes wrap (Lanes phase) noexcept
+    {
+        const auto one = Lanes::expand(1.0f);
+        return phase - (one & Lanes::greaterThanOrEqual(phase, one));
+    }
+};
@@ -0,0 +1,106 @@
+/*
+  ==============================================================================
+
+    RealtimeSwap.h
+    Hands objects built on a background thread to the audio thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <memory>
+#include <utility>
+
+//==============================================================================
+/** One object in use by the audio thread, replaced by whatever a background
+    thread publishes next, without the audio thread ever locking, allocating
+    or freeing.
+
+    publish() leaves the object in a pending slot. The audio thread takes it
+    from there in update(), switches its users over to it and drops the one
+    it replaces into a retired slot, which collectGarbage() empties and frees
+    on another thread. A published object the audio thread never took
+    (nothing playing) is freed by the next publish() instead.
+
+    The audio thread only takes a pending object while the retired slot is
+    empty, so nothing is ever dropped; until the slot is collected, newer
+    objects wait. Call collectGarbage() regularly from the publishing side.
+
+    Users that need a few more blocks to finish with the replaced object take
+    the new one with updateKeepingPrevious() instead, and retire the old one
+    with releasePrevious() when they're done; newer objects wait until then.
+*/
+template <typename Object>
+class RealtimeSwap
+{
+public:
+    //==============================================================================
+    RealtimeSwap () = default;
+    ~RealtimeSwap ()
+    {
+        collectGarbage();
+        delete _pending.exchange(nullptr);
+        delete _previous;
+        delete _current;
+    }
+
+    //==============================================================================
+    void publish (std::unique_ptr<Object> object)
+    {
+        std::unique_ptr<Object> untaken(_pending.exchange(nullptr)); // the audio thread never saw it
+        collectGarbage();
+        _pending.store(object.release());
+    }
+    // Frees what the audio thread let go of; any thread but that one.
+    void collectGarbage ()
+    {
+        std::unique_ptr<Object> retired(_retired.exchange(nullptr));
+    }
+
+    //==============================================================================
+    // Audio thread: calls use with a newly published object, if there is one,
+    // and only retires the previous one after use has moved everything off it.
+    template <typename Use>
+    void update (Use&& use) noexcept
+    {
+        updateKeepingPrevious(std::forward<Use>(use));
+        releasePrevious();
+    }
+    // Audio thread: like update(), but the object replaced stays alive until
+    // releasePrevious().
+    template <typename Use>
+    void updateKeepingPrevious (Use&& use) noexcept
+    {
+        if (_previous != nullptr || _retired.load() != nullptr)
+        {
+            return; // the last one isn't freed yet, take the next one later
+        }
+        if (auto* next = _pending.exchange(nullptr))
+        {
+            use(static_cast<const Object*>(next));
+            _previous = _current;
+            _current  = next;
+        }
+    }
+    // Audio thread: retires the object the last update replaced, nothing may
+    // read it any more.
+    void releasePrevious () noexcept
+    {
+        if (_previous == nullptr) return;
+        jassert (_retired.load() == nullptr); // only taken while it was empty
+        _retired.store(_previous);
+        _previous = nullptr;
+    }
+
+private:
+    //==============================================================================
+    std::atomic<Object*> _pending { nullptr };
+    std::atomic<Object*> _retired { nullptr };
+    Object*              _current  = nullptr; // the audio thread's, and the destructor's
+    Object*              _previous = nullptr; // same, replaced but not retired yet
+
+    JUCE_DECLARE_NON_COPYABLE (RealtimeSwap)
+};
@@ -0,0 +1,195 @@
+/*
+  ==============================================================================
+
+    RealtimeWorkerPool.h
+    Worker threads that help the audio thread through a batch of tasks.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+
+//==============================================================================
+/** Fixed set of pinned worker threads that share a batch of independent tasks
+    with the calling (audio) thread.
+
+    parallelFor() never locks or allocates: tasks are handed out through a
+    single atomic word holding the batch generation, its task count and the
+    next task index, so a worker that wakes up late can never pick up a task
+    of a newer batch. The caller takes part in the batch itself and then
+    spins until every task is done.
+
+    Idle workers spin, then yield, and only fall back to short sleeps once no
+    batch arrived for a while (transport stopped), so they are awake and ready
+    while audio is running.
+
+    Each worker is pinned to one core. Nothing pins the host's audio thread,
+    so it may land on a worker's core; and every plugin instance runs a pool
+    of its own. Pools therefore take their cores in turn, each starting
+    where the previous one stopped, so two instances only share cores once
+    their workers together outnumber them.
+
+    Construction and destruction start and stop threads: do both off the
+    audio thread.
+*/
+class RealtimeWorkerPool
+{
+public:
+    //==============================================================================
+    explicit RealtimeWorkerPool (int num_of_workers)
+    {
+        // the affinity mask only addresses the first 32 cores
+        const auto num_of_cores = juce::jlimit(1, MAX_CORES, juce::SystemStats::getNumCpus());
+        const auto first_core   = claimCores(num_of_workers, num_of_cores);
+        for (int index = 0; index < num_of_workers; ++index)
+        {
+            auto* worker = _workers.add(new Worker(*this, index + 1));
+            worker->setAffinityMask(1u << ((first_core + index) % num_of_cores));
+            worker->startThread(9); // just below the host's audio thread
+        }
+    }
+    ~RealtimeWorkerPool ()
+    {
+        for (auto* worker : _workers)
+        {
+            worker->signalThreadShouldExit();
+        }
+        for (auto* worker : _workers)
+        {
+            worker->stopThread(1000);
+        }
+    }
+
+    //==============================================================================
+    // The workers plus the calling thread, participant 0.
+    int getNumOfParticipants () const noexcept
+    {
+        return _workers.size() + 1;
+    }
+
+    //==============================================================================
+    // Calls task(participant, task_index) once for every index in [0, num_of_tasks),
+    // spread over all participants, and returns when all of them are done.
+    template <typename Task>
+    void parallelFor (int num_of_tasks, Task& task) noexcept
+    {
+        run(num_of_tasks, &task, [](void* context, int participant, int task_index) {
+            (*static_cast<Task*>(context))(participant, task_index);
+        });
+    }
+
+private:
+    //==============================================================================
+    using TaskFunction = void (*)(void*, int, int);
+
+    //==============================================================================
+    class Worker : public juce::Thread
+    {
+    public:
+        Worker (RealtimeWorkerPool& pool, int participant):
+            juce::Thread("Voice render worker " + juce::String(participant)),
+            _pool(pool),
+            _participant(participant)
+        {}
+
+        void run () override
+        {
+            auto seen      = _pool.currentGeneration();
+            auto last_work = juce::Time::getMillisecondCounter();
+            for (int idle = 0; !threadShouldExit(); ++idle)
+            {
+                const auto generation = _pool.currentGeneration();
+                if (generation != seen)
+                {
+                    seen      = generation;
+                    idle      = 0;
+                    last_work = juce::Time::getMillisecondCounter();
+                    _pool.runTasks(generation, _participant);
+                } else if (idle > SPIN_COUNT)
+                {
+                    if (juce::Time::getMillisecondCounter() - last_work > SLEEP_AFTER_IDLE_MS) { wait(1); }
+                    else                                                                       { juce::Thread::yield(); }
+                }
+            }
+        }
+
+    private:
+        static constexpr int         SPIN_COUNT          = 2000;
+        static constexpr juce::uint32 SLEEP_AFTER_IDLE_MS = 100;
+
+        RealtimeWorkerPool& _pool;
+        const int           _participant;
+    };
+
+    //==============================================================================
+    static constexpr int MAX_CORES = 32;
+
+    // The first of num_of_workers cores for a new pool, after those the previous pool took.
+    static int claimCores (int num_of_workers, int num_of_cores) noexcept
+    {
+        static std::atomic<int> next_core { 1 }; // core 0 is where the OS tends to put everything else
+        auto first = next_core.load(std::memory_order_relaxed);
+        while (!next_core.compare_exchange_weak(first, (first + num_of_workers) % num_of_cores, std::memory_order_relaxed)) {}
+        return first % num_of_cores;
+    }
+
+    //==============================================================================
+    juce::OwnedArray<Worker>    _workers;
+    std::atomic<juce::uint64>   _work { 0 };        // generation << 32 | number of tasks << 16 | next task
+    std::atomic<int>            _num_of_done { 0 };
+    std::atomic<void*>          _task_context { nullptr };
+    std::atomic<TaskFunction>   _task_function { nullptr };
+    juce::uint32                _generation = 0;    // only touched by the calling thread
+
+    //==============================================================================
+    void run (int num_of_tasks, void* context, TaskFunction function) noexcept
+    {
+        if (num_of_tasks <= 0) return;
+        jassert (num_of_tasks <= 0xffff);
+
+        _task_function.store(function, std::memory_order_relaxed);
+        _task_context.store(context, std::memory_order_relaxed);
+        _num_of_done.store(0, std::memory_order_relaxed);
+        _work.store((static_cast<juce::uint64>(++_generation) << 32)
+                    | (static_cast<juce::uint64>(num_of_tasks) << 16), std::memory_order_release); // publishes the batch
+
+        runTasks(_generation, 0);
+        while (_num_of_done.load(std::memory_order_acquire) < num_of_tasks) {} // workers are finishing the last tasks
+    }
+    juce::uint32 currentGeneration () const noexcept
+    {
+        return static_cast<juce::uint32>(_work.load(std::memory_order_acquire) >> 32);
+    }
+    void runTasks (juce::uint32 generation, int participant) noexcept
+    {
+        // read once: if these already belong to a newer batch, every claim below fails
+        const auto function = _task_function.load(std::memory_order_relaxed);
+        const auto context  = _task_context.load(std::memory_order_relaxed);
+
+        for (int task_index; claimTask(generation, task_index);)
+        {
+            function(context, participant, task_index);
+            _num_of_done.fetch_add(1, std::memory_order_release);
+        }
+    }
+    bool claimTask (juce::uint32 generation, int& task_index) noexcept
+    {
+        auto work = _work.load(std::memory_order_acquire);
+        for (;;)
+        {
+            if (static_cast<juce::uint32>(work >> 32) != generation) return false; // a newer batch started
+            const auto next = static_cast<int>(work & 0xffffu);
+            if (next >= static_cast<int>((work >> 16) & 0xffffu)) return false;
+            if (_work.compare_exchange_weak(work, work + 1, std::memory_order_acq_rel))
+            {
+                task_index = next;
+                return true;
+            }
+        }
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (RealtimeWorkerPool)
+};
@@ -0,0 +1,133 @@
+/*
+  ==============================================================================
+
+    Sample.h
+    Decoded or memory-mapped audio a granular voice reads from.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <memory>
+
+//==============================================================================
+/** An audio file, one or two channels at the rate it was recorded at.
+
+    Short files are decoded into memory and read straight from there, see
+    getAudio(). Long uncompressed WAV and AIFF files are memory-mapped
+    instead: nothing is decoded up front, readers convert the frames they
+    need with readFrames(), and only the pages actually played become
+    resident, shared with every other instance mapping the same file.
+
+    Immutable once built and reference counted, so the audio thread, the
+    editor and the loader can share one without copying or locking. The
+    audio thread never holds a reference of its own: it reads through the
+    RealtimeSwap that handed the sample over, which makes sure the last
+    reference is never dropped on it.
+*/
+class Sample : public juce::ReferenceCountedObject
+{
+public:
+    //==============================================================================
+    using Ptr = juce::ReferenceCountedObjectPtr<Sample>;
+
+    static constexpr int MAX_CHANNELS = 2;
+
+    //==============================================================================
+    // Takes the decoded audio over, nothing is copied.
+    Sample (juce::AudioBuffer<float>&& audio, double sample_rate, const juce::String& name):
+        _audio(std::move(audio)),
+        _num_channels(_audio.getNumChannels()),
+        _num_samples(_audio.getNumSamples()),
+        _sample_rate(sample_rate),
+        _name(name)
+    {}
+    // Takes over a reader with the whole file mapped.
+    Sample (std::unique_ptr<juce::MemoryMappedAudioFormatReader> mapped, const juce::String& name):
+        _mapped(std::move(mapped)),
+        _num_channels(juce::jlimit(1, MAX_CHANNELS, static_cast<int>(_mapped->numChannels))),
+        _num_samples(static_cast<int>(_mapped->lengthInSamples)),
+        _sample_rate(_mapped->sampleRate),
+        _name(name)
+    {
+        jassert (_mapped->getMappedSection().getLength() == _mapped->lengthInSamples);
+    }
+
+    //==============================================================================
+    bool isMapped () const noexcept
+    {
+        return _mapped != nullptr;
+    }
+    // The decoded audio, empty when mapped.
+    const juce::AudioBuffer<float>& getAudio () const noexcept
+    {
+        return _audio;
+    }
+    // Converts num_frames frames from start on into one destination per
+    // channel. Doesn't allocate or lock, but frames not played or touched
+    // before may have to come from disk first: see touchFrames().
+    void readFrames (float* const* destination, juce::int64 start, int num_frames) const noexcept
+    {
+        if (_mapped != nullptr)
+        {
+            _mapped->read(destination, _num_channels, start, num_frames);
+            return;
+        }
+        for (int channel = 0; channel < _num_channels; ++channel)
+        {
+            juce::FloatVectorOperations::copy(destination[channel], _audio.getReadPointer(channel, static_cast<int>(start)), num_frames);
+        }
+    }
+    // Reads a byte of every page of the mapped frames in the range, so the
+    // system brings them in before a reader needs them. Any thread but the
+    // audio one; does nothing for decoded samples.
+    void touchFrames (juce::Range<juce::int64> frames) const noexcept
+    {
+        if (_mapped == nullptr) return;
+        const auto range = frames.getIntersectionWith({ 0, static_cast<juce::int64>(_num_samples) });
+        const auto bytes_per_frame = juce::jmax(1, static_cast<int>(_mapped->numChannels * _mapped->bitsPerSample / 8));
+        const auto frames_per_page = juce::jmax(1, PAGE_SIZE / bytes_per_frame);
+        for (auto frame = range.getStart(); frame < range.getEnd(); frame += frames_per_page)
+        {
+            _mapped->touchSample(frame);
+        }
+    }
+
+    //==============================================================================
+    int getNumChannels () const noexcept
+    {
+        return _num_channels;
+    }
+    int getNumSamples () const noexcept
+    {
+        return _num_samples;
+    }
+    double getSampleRate () const noexcept
+    {
+        return _sample_rate;
+    }
+    double getLengthInSeconds () const noexcept
+    {
+        return getNumSamples() / _sample_rate;
+    }
+    const juce::String& getName () const noexcept
+    {
+        return _name;
+    }
+
+private:
+    //==============================================================================
+    static constexpr int PAGE_SIZE = 4096; // the smallest in use, touching more often is harmless
+
+    //==============================================================================
+    const juce::AudioBuffer<float>                                 _audio;
+    const std::unique_ptr<juce::MemoryMappedAudioFormatReader>     _mapped;
+    const int                                                      _num_channels;
+    const int                                                      _num_samples;
+    const double                                                   _sample_rate;
+    const juce::String                                             _name;
+
+    JUCE_DECLARE_NON_COPYABLE (Sample)
+};
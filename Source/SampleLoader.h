@@ -0,0 +1,190 @@
+/*
+  ==============================================================================
+
+    SampleLoader.h
+    Decodes or maps audio files into samples on a background thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include "RealtimeSwap.h"
+#include "Sample.h"
+
+//==============================================================================
+/** Decodes dropped audio files into Samples and publishes them to the audio
+    thread through a RealtimeSwap, which holds a reference to the sample the
+    audio thread plays. The reference of a replaced sample is dropped here,
+    never on the audio thread.
+
+    load() only notes the file and wakes the loader thread. Decoding goes in
+    chunks, so a newer request or shutting down cancels a long file early
+    instead of waiting minutes for it. Between requests the thread frees the
+    samples the audio thread let go of.
+
+    Long uncompressed WAV and AIFF files are memory-mapped instead of decoded
+    (see Sample), so hour-long recordings load at once and take no more
+    memory than the stretches that get played. Reading them may have to wait
+    for the disk, which must not happen on the audio thread: while a mapped
+    sample is the latest one, this thread touches the pages around where
+    the grains play every PREFETCH_INTERVAL_MS, see prefetch().
+
+    Files keep their first two channels and their sample rate.
+*/
+class SampleLoader : private juce::Thread
+{
+public:
+    //==============================================================================
+    using Samples = RealtimeSwap<Sample::Ptr>;
+
+    //==============================================================================
+    explicit SampleLoader (Samples& samples):
+        juce::Thread("Sample loader"),
+        _samples(samples)
+    {
+        _formats.registerBasicFormats();
+        startThread(3); // below the UI, far below audio
+    }
+    ~SampleLoader () override
+    {
+        stopThread(4000);
+    }
+
+    //==============================================================================
+    // Audio thread, after every block: the frames grains play from next, in
+    // the latest sample. Only stored here, the loader thread touches them.
+    void prefetch (juce::Range<juce::int64> frames) noexcept
+    {
+        _prefetch_start.store(frames.getStart());
+        _prefetch_end.store(frames.getEnd());
+    }
+    bool canLoad (const juce::File& file) const
+    {
+        return _formats.findFormatForFileExtension(file.getFileExtension()) != nullptr;
+    }
+    // Any thread but the audio one, returns at once.
+    void load (const juce::File& file)
+    {
+        {
+            const juce::ScopedLock lock(_request_lock);
+            _requested = file;
+        }
+        notify();
+    }
+
+private:
+    //==============================================================================
+    static constexpr int COLLECT_INTERVAL_MS  = 500;
+    static constexpr int PREFETCH_INTERVAL_MS = 50;
+    static constexpr int CHUNK_LENGTH         = 1 << 16; // samples decoded between checks for cancellation
+    static constexpr int MAX_CHANNELS         = Sample::MAX_CHANNELS;
+    // Files that would decode to more floats than this are mapped, 64 MB.
+    static constexpr juce::int64 MAX_DECODED_SAMPLES = 1 << 24;
+    // Longer stretches aren't all touched, only as much around their middle:
+    // grains jittered over a whole recording would make all of it resident.
+    static constexpr double MAX_PREFETCH_SECONDS = 20.0;
+
+    //==============================================================================
+    void run () override
+    {
+        while (! threadShouldExit())
+        {
+            _samples.collectGarbage();
+
+            juce::File file;
+            {
+                const juce::ScopedLock lock(_request_lock);
+                std::swap(file, _requested);
+            }
+            if (file != juce::File())
+            {
+                build(file);
+            }
+            touchPlayedFrames();
+            // returns at once when load() was called meanwhile
+            wait((_latest != nullptr && _latest->isMapped()) ? PREFETCH_INTERVAL_MS : COLLECT_INTERVAL_MS);
+        }
+    }
+    void build (const juce::File& file)
+    {
+        if (auto* format = _formats.findFormatForFileExtension(file.getFileExtension()))
+        {
+            std::unique_ptr<juce::MemoryMappedAudioFormatReader> mapped(format->createMemoryMappedReader(file));
+            if (mapped != nullptr && isWorthMapping(*mapped) && mapped->mapEntireFile())
+            {
+                publish(new Sample(std::move(mapped), file.getFileNameWithoutExtension()));
+                return;
+            }
+            // compressed, short or not mappable (address space), decoded below
+        }
+
+        std::unique_ptr<juce::AudioFormatReader> reader(_formats.createReaderFor(file));
+        if (reader == nullptr || reader->lengthInSamples <= 0 || reader->sampleRate <= 0.0)
+        {
+            DBG("Sample loader: can't read " << file.getFullPathName());
+            return;
+        }
+        if (reader->lengthInSamples > std::numeric_limits<int>::max())
+        {
+            DBG("Sample loader: " << file.getFullPathName() << " is too long");
+            return;
+        }
+
+        const auto num_samples  = static_cast<int>(reader->lengthInSamples);
+        const auto num_channels = juce::jlimit(1, MAX_CHANNELS, static_cast<int>(reader->numChannels));
+        juce::AudioBuffer<float> audio(num_channels, num_samples);
+        for (int start = 0; start < num_samples; start += CHUNK_LENGTH)
+        {
+            if (threadShouldExit() || hasNewRequest())
+            {
+                return; // whatever comes next replaces it anyway
+            }
+            reader->read(&audio, start, juce::jmin(CHUNK_LENGTH, num_samples - start), start, true, num_channels > 1);
+        }
+
+        publish(new Sample(std::move(audio), reader->sampleRate, file.getFileNameWithoutExtension()));
+    }
+    static bool isWorthMapping (const juce::AudioFormatReader& reader)
+    {
+        const auto num_channels = juce::jlimit(1, MAX_CHANNELS, static_cast<int>(reader.numChannels));
+        return reader.lengthInSamples > 0 && reader.sampleRate > 0.0
+            && reader.lengthInSamples <= std::numeric_limits<int>::max()
+            && reader.lengthInSamples * num_channels > MAX_DECODED_SAMPLES;
+    }
+    void publish (Sample* sample)
+    {
+        _latest = sample;
+        _prefetch_start.store(0); // nothing known about where grains play in it yet
+        _prefetch_end.store(0);
+        _samples.publish(std::make_unique<Sample::Ptr>(sample));
+    }
+    void touchPlayedFrames ()
+    {
+        if (_latest == nullptr || ! _latest->isMapped()) return;
+        const juce::Range<juce::int64> frames(_prefetch_start.load(), _prefetch_end.load());
+        const auto max_length = static_cast<juce::int64>(MAX_PREFETCH_SECONDS * _latest->getSampleRate());
+        const auto centre     = frames.getStart() + frames.getLength() / 2;
+        _latest->touchFrames(frames.getLength() <= max_length ? frames : juce::Range<juce::int64>(centre - max_length / 2, centre + max_length / 2));
+    }
+    bool hasNewRequest ()
+    {
+        const juce::ScopedLock lock(_request_lock);
+        return _requested != juce::File();
+    }
+
+    //==============================================================================
+    Samples&                 _samples;
+    juce::AudioFormatManager _formats;
+    juce::CriticalSection    _request_lock;
+    juce::File               _requested;
+    Sample::Ptr              _latest; // the one prefetched for, this thread's
+    std::atomic<juce::int64> _prefetch_start { 0 };
+    std::atomic<juce::int64> _prefetch_end   { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE (SampleLoader)
+};
@@ -0,0 +1,184 @@
+/*
+  ==============================================================================
+
+    SampleReader.h
+    Fractional reads of sample data, one grain per SIMD lane.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <cmath>
+#include <vector>
+
+//==============================================================================
+/** Interpolating readers for grains playing a Sample at arbitrary rates,
+    side by side: every lane of a register reads for another grain, so a
+    register of 8 floats (AVX) advances 8 grains per instruction, one of 4
+    (SSE, NEON) 4 of them.
+
+    SIMDRegister can't gather, so reading goes in two steps. Points::gather()
+    copies the frames around each lane's read position into point-major
+    storage, one register per point across the lanes; a kernel then
+    interpolates all lanes at once from those registers and the lanes'
+    fractions. Kernels differ in how many points they read around the
+    position (from FIRST on), which is all the gathering needs to know:
+
+        Linear    2 points, cheapest, dulls the top octave and aliases
+        Hermite   4 points, third-order Catmull-Rom, good for realtime
+        Sinc      16 points, Blackman-windowed sinc, for offline renders
+                  or when quality matters more than the grain count
+
+    No kernel reads further than MARGIN frames from the position; grains
+    keep at least that far from both ends of the sample, so nothing is
+    clamped per read. The kernels don't filter beyond the source's own
+    Nyquist, grains pitched up can still alias.
+*/
+class SampleReader
+{
+public:
+    //==============================================================================
+    using Lanes = juce::dsp::SIMDRegister<float>;
+
+    static constexpr size_t NUM_LANES = Lanes::SIMDNumElements;
+    static constexpr int    MARGIN    = 8;
+
+    //==============================================================================
+    // The frames around the read positions of every lane, and the fractions
+    // past the frame each position is at.
+    template <int NUM_POINTS>
+    struct Points
+    {
+        // Scalar: each lane reads elsewhere in the sample.
+        void gather (size_t lane, const float* source, int index, int first, float fraction) noexcept
+        {
+            const auto* frames = source + index + first;
+            for (int point = 0; point < NUM_POINTS; ++point)
+            {
+                values[static_cast<size_t>(point) * NUM_LANES + lane] = frames[point];
+            }
+            fractions[lane] = fraction;
+        }
+        Lanes point (int point) const noexcept
+        {
+            return Lanes::fromRawArray(values + static_cast<size_t>(point) * NUM_LANES);
+        }
+        Lanes fraction () const noexcept
+        {
+            return Lanes::fromRawArray(fractions);
+        }
+
+        alignas (Lanes::SIMDRegisterSize) float values[NUM_POINTS * NUM_LANES];
+        alignas (Lanes::SIMDRegisterSize) float fractions[NUM_LANES];
+    };
+
+    //==============================================================================
+    struct Linear
+    {
+        static constexpr int NUM_POINTS = 2;
+        static constexpr int FIRST      = 0;
+
+        static Lanes interpolate (const Points<NUM_POINTS>& points) noexcept
+        {
+            const auto y0 = points.point(0);
+            return y0 + points.fraction() * (points.point(1) - y0);
+        }
+    };
+
+    struct Hermite
+    {
+        static constexpr int NUM_POINTS = 4;
+        static constexpr int FIRST      = -1;
+
+        static Lanes interpolate (const Points<NUM_POINTS>& points) noexcept
+        {
+            const auto ym1 = points.point(0);
+            const auto y0  = points.point(1);
+            const auto y1  = points.point(2);
+            const auto y2  = points.point(3);
+            const auto x   = points.fraction();
+            const auto c1  = (y1 - ym1) * 0.5f;
+            const auto c2  = ym1 - y0 * 2.5f + y1 * 2.0f - y2 * 0.5f;
+            const auto c3  = (y2 - ym1) * 0.5f + (y0 - y1) * 1.5f;
+            return ((c3 * x + c2) * x + c1) * x + y0;
+        }
+    };
+
+    struct Sinc
+    {
+        static constexpr int NUM_POINTS = 2 * MARGIN;
+        static constexpr int FIRST      = 1 - MARGIN;
+        // Fractions the taps are tabulated at, blended linearly in between.
+        static constexpr int NUM_PHASES = 512;
+        // Passband edge in cycles per source frame; the window rolls off above it.
+        static constexpr double CUTOFF  = 0.48;
+
+        // Taps for every phase plus a guard one at fraction 1, allocates:
+        // call it off the audio thread first.
+        static const std::vector<float>& getTaps ()
+        {
+            static const std::vector<float> taps = buildTaps();
+            return taps;
+        }
+        static Lanes interpolate (const Points<NUM_POINTS>& points) noexcept
+        {
+            const auto* taps = getTaps().data();
+            alignas (Lanes::SIMDRegisterSize) float blend[NUM_LANES];
+            const float* rows[NUM_LANES];
+            for (size_t lane = 0; lane < NUM_LANES; ++lane)
+            {
+                const auto phase = points.fractions[lane] * NUM_PHASES;
+                const auto row   = juce::jlimit(0, NUM_PHASES - 1, static_cast<int>(phase));
+                blend[lane] = phase - static_cast<float>(row);
+                rows[lane]  = taps + row * NUM_POINTS;
+            }
+
+            const auto row_blend = Lanes::fromRawArray(blend);
+            alignas (Lanes::SIMDRegisterSize) float tap[NUM_LANES];
+            alignas (Lanes::SIMDRegisterSize) float next_tap[NUM_LANES];
+            auto sum = Lanes::expand(0.0f);
+            for (int point = 0; point < NUM_POINTS; ++point)
+            {
+                for (size_t lane = 0; lane < NUM_LANES; ++lane)
+                {
+                    tap[lane]      = rows[lane][point];
+                    next_tap[lane] = rows[lane][point + NUM_POINTS];
+                }
+                const auto weight = Lanes::fromRawArray(tap) + row_blend * (Lanes::fromRawArray(next_tap) - Lanes::fromRawArray(tap));
+                sum += points.point(point) * weight;
+            }
+            return sum;
+        }
+
+    private:
+        static std::vector<float> buildTaps ()
+        {
+            std::vector<float> taps(static_cast<size_t>((NUM_PHASES + 1) * NUM_POINTS));
+            for (int phase = 0; phase <= NUM_PHASES; ++phase)
+            {
+                const auto fraction = static_cast<double>(phase) / NUM_PHASES;
+                auto* row = taps.data() + phase * NUM_POINTS;
+                double total = 0.0;
+                for (int point = 0; point < NUM_POINTS; ++point)
+                {
+                    const auto x = static_cast<double>(point + FIRST) - fraction; // frames from the read position
+                    const auto u = x / MARGIN;                                    // -1 to 1 over the taps
+                    const auto window = 0.42 + 0.5 * std::cos(juce::MathConstants<double>::pi * u)
+                                      + 0.08 * std::cos(juce::MathConstants<double>::twoPi * u);
+                    const auto arg = juce::MathConstants<double>::twoPi * CUTOFF * x;
+                    const auto sinc = (std::abs(arg) < 1e-9) ? 1.0 : std::sin(arg) / arg;
+                    const auto tap  = 2.0 * CUTOFF * sinc * juce::jmax(0.0, window);
+                    row[point] = static_cast<float>(tap);
+                    total += tap;
+                }
+                for (int point = 0; point < NUM_POINTS; ++point)
+                {
+                    row[point] = static_cast<float>(row[point] / total); // unity gain at DC, for every phase
+                }
+            }
+            return taps;
+        }
+    };
+};
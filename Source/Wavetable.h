@@ -0,0 +1,264 @@
+/*
+  ==============================================================================
+
+    Wavetable.h
+    Band-limited, mipmapped single-cycle tables shared by all voices.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+//==============================================================================
+/** One single-cycle waveform stored as a stack of band-limited tables, one per
+    octave of playback pitch. Level 0 holds the most harmonics, every next level
+    half as many, so whatever the pitch there is a level whose top harmonic stays
+    below Nyquist.
+
+    Levels are chosen from the phase increment (cycles per sample), which makes
+    the tables independent of the sample rate. A Wavetable is immutable once
+    built, so any number of voices and plugin instances can read it without
+    synchronisation.
+*/
+class Wavetable
+{
+public:
+    //==============================================================================
+    static constexpr int SIZE          = 2048;
+    static constexpr int NUM_OF_LEVELS = 10;
+    static constexpr int MAX_HARMONICS = SIZE / 4; // level 0, halved per level
+
+    // Amplitude of the sine partial with the given harmonic number (from 1).
+    using HarmonicFunction = std::function<double(int)>;
+
+    //==============================================================================
+    // Additive synthesis of every level, allocates: build off the audio thread.
+    explicit Wavetable (const HarmonicFunction& amplitude)
+    {
+        std::vector<double> sine(SIZE);
+        for (int index = 0; index < SIZE; ++index)
+        {
+            sine[static_cast<size_t>(index)] = std::sin(juce::MathConstants<double>::twoPi * index / SIZE);
+        }
+
+        _data.resize(static_cast<size_t>(NUM_OF_LEVELS * STRIDE));
+        std::vector<double> level(SIZE);
+        for (int level_index = 0; level_index < NUM_OF_LEVELS; ++level_index)
+        {
+            std::fill(level.begin(), level.end(), 0.0);
+            for (int harmonic = 1; harmonic <= (MAX_HARMONICS >> level_index); ++harmonic)
+            {
+                const auto gain = amplitude(harmonic);
+                for (int index = 0; index < SIZE; ++index)
+                {
+                    level[static_cast<size_t>(index)] += gain * sine[static_cast<size_t>((harmonic * index) % SIZE)];
+                }
+            }
+
+            auto* table = _data.data() + level_index * STRIDE;
+            for (int index = 0; index < SIZE; ++index)
+            {
+                table[index] = static_cast<float>(level[static_cast<size_t>(index)]);
+            }
+            table[SIZE] = table[0]; // guard point, interpolation never wraps
+        }
+    }
+
+    // One recorded cycle of frame_size samples, a power of two, resampled to
+    // SIZE through its spectrum: every level keeps the partials it has room
+    // for, up to max_partials, with their phases; DC is dropped. Allocates,
+    // build off the audio thread.
+    Wavetable (const float* frame, int frame_size, float gain = 1.0f, int max_partials = MAX_HARMONICS)
+    {
+        jassert (juce::isPowerOfTwo(frame_size) && frame_size >= 4);
+        
+        std::vector<float> spectrum(static_cast<size_t>(2 * frame_size), 0.0f);
+        std::copy(frame, frame + frame_size, spectrum.begin());
+        juce::dsp::FFT(juce::roundToInt(std::log2(frame_size))).performRealOnlyForwardTransform(spectrum.data(), true);
+        
+        // the inverse transform divides by SIZE, the forward one didn't divide by frame_size
+        const auto scale = gain * static_cast<float>(SIZE) / static_cast<float>(frame_size);
+        const auto num_of_partials = juce::jmin(max_partials, MAX_HARMONICS, frame_size / 2 - 1); // Nyquist has no phase
+        
+        juce::dsp::FFT inverse(juce::roundToInt(std::log2(SIZE)));
+        std::vector<float> level(static_cast<size_t>(2 * SIZE));
+        _data.resize(static_cast<size_t>(NUM_OF_LEVELS * STRIDE));
+        for (int level_index = 0; level_index < NUM_OF_LEVELS; ++level_index)
+        {
+            std::fill(level.begin(), level.end(), 0.0f);
+            for (int harmonic = 1; harmonic <= juce::jmin(num_of_partials, MAX_HARMONICS >> level_index); ++harmonic)
+            {
+                const auto re = spectrum[static_cast<size_t>(2 * harmonic)]     * scale;
+                const auto im = spectrum[static_cast<size_t>(2 * harmonic + 1)] * scale;
+                level[static_cast<size_t>(2 * harmonic)]              = re;
+                level[static_cast<size_t>(2 * harmonic + 1)]          = im;
+                level[static_cast<size_t>(2 * (SIZE - harmonic))]     = re; // the mirrored half, conjugated
+                level[static_cast<size_t>(2 * (SIZE - harmonic) + 1)] = -im;
+            }
+            inverse.performRealOnlyInverseTransform(level.data());
+            
+            auto* table = _data.data() + level_index * STRIDE;
+            std::copy(level.begin(), level.begin() + SIZE, table);
+            table[SIZE] = table[0];
+        }
+    }
+
+    //==============================================================================
+    // Table with as many harmonics as fit below Nyquist at this increment.
+    const float* getLevel (float phase_increment) const noexcept
+    {
+        int level_index = 0;
+        while (level_index < NUM_OF_LEVELS - 1 && phase_increment * static_cast<float>(MAX_HARMONICS >> level_index) >= 0.5f)
+        {
+            ++level_index;
+        }
+        return _data.data() + level_index * STRIDE;
+    }
+    // Linear interpolation, phase normalised to [0, 1).
+    static float lookup (const float* table, float phase) noexcept
+    {
+        const auto position = phase * static_cast<float>(SIZE);
+        const auto index    = juce::jlimit(0, SIZE - 1, static_cast<int>(position));
+        const auto fraction = position - static_cast<float>(index);
+        return table[index] + fraction * (table[index + 1] - table[index]);
+    }
+    // Between two tables of the same size, blend 0 is all the first: the index
+    // is worked out once for both, so it costs little more than one lookup.
+    static float lookup (const float* table, const float* next_table, float blend, float phase) noexcept
+    {
+        const auto position = phase * static_cast<float>(SIZE);
+        const auto index    = juce::jlimit(0, SIZE - 1, static_cast<int>(position));
+        const auto fraction = position - static_cast<float>(index);
+        const auto value    = table[index]      + fraction * (table[index + 1]      - table[index]);
+        const auto next     = next_table[index] + fraction * (next_table[index + 1] - next_table[index]);
+        return value + blend * (next - value);
+    }
+
+private:
+    //==============================================================================
+    static constexpr int STRIDE = SIZE + 1;
+
+    std::vector<float> _data;
+
+    JUCE_DECLARE_NON_COPYABLE (Wavetable)
+};
+
+//==============================================================================
+/** The frames of a wavetable loaded from an audio file, each one a Wavetable
+    of its own. The whole set is scaled by one gain, so frames keep their
+    relative levels while the loudest one peaks at about full scale. Immutable
+    once built, like Wavetable.
+
+    Oscillators scan it by position: they read the two frames around it and
+    blend them per sample, the tables themselves never change.
+*/
+class UserWavetable
+{
+public:
+    //==============================================================================
+    static constexpr int MAX_FRAMES = 256;
+    
+    // Files are sliced into the longest power of two frames in this range
+    // they are a multiple of. One that is none of their multiples is one frame.
+    static constexpr int MAX_FRAME_SIZE = 2048;
+    static constexpr int MIN_FRAME_SIZE = 256;
+    
+    //==============================================================================
+    // Slices samples into frames and builds every one of them. Allocates and
+    // takes a while for long files, build off the audio thread.
+    UserWavetable (const float* samples, int num_samples, const juce::String& name):
+        _name(name)
+    {
+        jassert (num_samples > 0);
+        
+        // a single cycle of any other length is stretched to a table linearly,
+        // the partials it couldn't hold are left out again
+        std::vector<float> stretched;
+        auto frame_size   = getFrameSize(num_samples);
+        auto num_partials = Wavetable::MAX_HARMONICS;
+        if (frame_size == 0)
+        {
+            stretched.resize(Wavetable::SIZE);
+            for (int index = 0; index < Wavetable::SIZE; ++index)
+            {
+                const auto position = static_cast<double>(index) * num_samples / Wavetable::SIZE;
+                const auto first    = static_cast<int>(position);
+                const auto fraction = static_cast<float>(position - first);
+                const auto current  = samples[first];
+                const auto next     = samples[(first + 1) % num_samples];
+                stretched[static_cast<size_t>(index)] = current + fraction * (next - current);
+            }
+            samples      = stretched.data();
+            frame_size   = Wavetable::SIZE;
+            num_partials = juce::jmax(1, num_samples / 2 - 1);
+            num_samples  = frame_size;
+        }
+        const auto num_frames = juce::jmin(MAX_FRAMES, num_samples / frame_size);
+        
+        auto peak = 0.0f;
+        for (int frame = 0; frame < num_frames; ++frame)
+        {
+            const auto* first = samples + frame * frame_size;
+            const auto  mean  = std::accumulate(first, first + frame_size, 0.0f) / static_cast<float>(frame_size);
+            for (int index = 0; index < frame_size; ++index)
+            {
+                peak = juce::jmax(peak, std::abs(first[index] - mean)); // DC doesn't make it into the tables
+            }
+        }
+        const auto gain = (peak > 0.0f) ? 1.0f / peak : 1.0f;
+        
+        _frames.reserve(static_cast<size_t>(num_frames));
+        for (int frame = 0; frame < num_frames; ++frame)
+        {
+            _frames.push_back(std::make_unique<Wavetable>(samples + frame * frame_size, frame_size, gain, num_partials));
+        }
+    }
+    
+    //==============================================================================
+    int getNumFrames () const noexcept
+    {
+        return static_cast<int>(_frames.size());
+    }
+    const Wavetable* getFrame (int index) const noexcept
+    {
+        return _frames[static_cast<size_t>(juce::jlimit(0, getNumFrames() - 1, index))].get();
+    }
+    // Position 0 is the first frame, 1 the last; the fractional part of the
+    // returned frame index is how far towards the next one it lies.
+    float getFramePosition (float position) const noexcept
+    {
+        return juce::jlimit(0.0f, 1.0f, position) * static_cast<float>(getNumFrames() - 1);
+    }
+    const juce::String& getName () const noexcept
+    {
+        return _name;
+    }
+    
+    //==============================================================================
+    // Frame length for a file, 0 when it isn't sliced: the whole file is one cycle.
+    static int getFrameSize (int num_samples) noexcept
+    {
+        for (int frame_size = MAX_FRAME_SIZE; frame_size >= MIN_FRAME_SIZE; frame_size /= 2)
+        {
+            if (num_samples % frame_size == 0)
+            {
+                return frame_size;
+            }
+        }
+        return 0;
+    }
+
+private:
+    //==============================================================================
+    std::vector<std::unique_ptr<Wavetable>> _frames;
+    juce::String _name;
+    
+    JUCE_DECLARE_NON_COPYABLE (UserWavetable)
+};
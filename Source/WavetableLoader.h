@@ -0,0 +1,111 @@
+/*
+  ==============================================================================
+
+    WavetableLoader.h
+    Decodes audio files into user wavetables on a background thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <memory>
+#include "RealtimeSwap.h"
+#include "Wavetable.h"
+
+//==============================================================================
+/** Turns dropped audio files into UserWavetables and publishes them to the
+    audio thread through a RealtimeSwap.
+
+    load() only notes the file and wakes the loader thread, so neither the UI
+    nor the audio callback ever waits on decoding or table building. A file
+    asked for while another one is being built replaces any still waiting,
+    only the latest one matters. Between requests the thread frees the tables
+    the audio thread let go of.
+
+    Only the first channel is read, up to MAX_FRAMES of the longest frame
+    size.
+*/
+class WavetableLoader : private juce::Thread
+{
+public:
+    //==============================================================================
+    using Tables = RealtimeSwap<UserWavetable>;
+
+    //==============================================================================
+    explicit WavetableLoader (Tables& tables):
+        juce::Thread("Wavetable loader"),
+        _tables(tables)
+    {
+        _formats.registerBasicFormats();
+        startThread(3); // below the UI, far below audio
+    }
+    ~WavetableLoader () override
+    {
+        stopThread(4000);
+    }
+
+    //==============================================================================
+    static bool canLoad (const juce::File& file)
+    {
+        return file.hasFileExtension("wav;aif;aiff");
+    }
+    // Any thread but the audio one, returns at once.
+    void load (const juce::File& file)
+    {
+        {
+            const juce::ScopedLock lock(_request_lock);
+            _requested = file;
+        }
+        notify();
+    }
+
+private:
+    //==============================================================================
+    static constexpr int COLLECT_INTERVAL_MS = 500;
+    static constexpr int MAX_LENGTH          = UserWavetable::MAX_FRAMES * UserWavetable::MAX_FRAME_SIZE;
+
+    //==============================================================================
+    void run () override
+    {
+        while (! threadShouldExit())
+        {
+            _tables.collectGarbage();
+
+            juce::File file;
+            {
+                const juce::ScopedLock lock(_request_lock);
+                std::swap(file, _requested);
+            }
+            if (file != juce::File())
+            {
+                build(file);
+            }
+            wait(COLLECT_INTERVAL_MS); // returns at once when load() was called meanwhile
+        }
+    }
+    void build (const juce::File& file)
+    {
+        std::unique_ptr<juce::AudioFormatReader> reader(_formats.createReaderFor(file));
+        if (reader == nullptr || reader->lengthInSamples <= 0)
+        {
+            DBG("Wavetable loader: can't read " << file.getFullPathName());
+            return;
+        }
+
+        const auto num_samples = static_cast<int>(juce::jmin<juce::int64>(reader->lengthInSamples, MAX_LENGTH));
+        juce::AudioBuffer<float> samples(1, num_samples);
+        reader->read(&samples, 0, num_samples, 0, true, false);
+
+        _tables.publish(std::make_unique<UserWavetable>(samples.getReadPointer(0), num_samples, file.getFileNameWithoutExtension()));
+    }
+
+    //==============================================================================
+    Tables&                  _tables;
+    juce::AudioFormatManager _formats;
+    juce::CriticalSection    _request_lock;
+    juce::File               _requested;
+
+    JUCE_DECLARE_NON_COPYABLE (WavetableLoader)
+};
@@ -0,0 +1,127 @@
+/*
+  ==============================================================================
+
+    EnvelopeTests.cpp
+    The amp envelope and the steal fade never jump, whatever changes under
+    them while they run.
+
+  ==============================================================================
+*/
+
+#include "PluginProcessor.h"
+
+//==============================================================================
+class EnvelopeTests : public juce::UnitTest
+{
+public:
+    EnvelopeTests (): juce::UnitTest("Envelope", "GGranula") {}
+
+    void runTest () override
+    {
+        beginTest("An attack set to no time mid-way ends there");
+        {
+            auto adsr = makeADSR();
+            adsr.noteOn();
+            step(adsr, 100);
+            adsr.setParameter(ADSRStages::ATTACK, 0.0f);
+            const auto level = step(adsr, 1);
+            expectEquals(adsr.getStage(), ADSRStages::DECAY);
+            expectWithinAbsoluteError(level, 1.0f, 1.0e-3f);
+            step(adsr, static_cast<int>(SAMPLE_RATE)); // through the decay
+            expectEquals(adsr.getLevel(), SUSTAIN);
+        }
+
+        beginTest("A decay set to no time mid-way ends at the sustain level");
+        {
+            auto adsr = makeADSR();
+            adsr.setParameter(ADSRStages::ATTACK, 0.0f);
+            adsr.noteOn();
+            step(adsr, 100);
+            adsr.setParameter(ADSRStages::DECAY, 0.0f);
+            step(adsr, 1);
+            expectEquals(adsr.getStage(), ADSRStages::SUSTAIN);
+            expectEquals(adsr.getLevel(), SUSTAIN);
+        }
+
+        for (auto render_mode : { VoiceRenderMode::PER_VOICE, VoiceRenderMode::SIMD_BANK })
+        {
+            beginTest(juce::String("A voice stolen again while fading keeps fading, ")
+                      + (render_mode == VoiceRenderMode::PER_VOICE ? "per voice" : "SIMD bank"));
+
+            // a single voice on an 8 Hz sine, stolen near its peak where it's all but constant
+            SynthesizerState::SynthesizerInitialState initial_state;
+            initial_state.osc_2_wave_type   = VoiceWaveType::SIN;
+            initial_state.amp_attack        = 0.0f;
+            initial_state.amp_sustain       = 1.0f;
+            initial_state.filter_cutoff     = 20000.0f;
+            initial_state.num_of_voices     = 1;
+            initial_state.voice_render_mode = render_mode;
+            Synthesizer synthesizer(std::make_shared<SynthesizerState>(initial_state));
+            synthesizer.prepare({
+                .juce_spec = {
+                    .sampleRate       = SAMPLE_RATE,
+                    .maximumBlockSize = static_cast<juce::uint32>(BLOCK_SIZE),
+                    .numChannels      = 2
+                }
+            });
+
+            juce::AudioBuffer<float> output(2, NUM_BLOCKS * BLOCK_SIZE);
+            output.clear();
+            synthesizer.noteOn(juce::MidiMessage::noteOn(1, 0, 0.8f));
+            for (int block = 0; block < NUM_BLOCKS; ++block)
+            {
+                if (block == FIRST_STEAL || block == SECOND_STEAL) // the second a third into the fade
+                {
+                    synthesizer.noteOn(juce::MidiMessage::noteOn(1, block, 0.8f));
+                }
+                juce::dsp::AudioBlock<BufferData> chunk(output.getArrayOfWritePointers(), 2, static_cast<size_t>(block * BLOCK_SIZE), static_cast<size_t>(BLOCK_SIZE));
+                juce::dsp::ProcessContextReplacing<BufferData> context(chunk);
+                juce::MidiBuffer events;
+                synthesizer.renderNextBlock({ .juce_context = context }, events);
+            }
+
+            const auto* left = output.getReadPointer(0);
+            const auto peak  = output.getMagnitude(0, 0, FIRST_STEAL * BLOCK_SIZE);
+            float max_step = 0.0f;
+            for (int sample = 1; sample < output.getNumSamples(); ++sample)
+            {
+                max_step = juce::jmax(max_step, std::abs(left[sample] - left[sample - 1]));
+            }
+            expect(peak > 0.01f, "nothing played");
+            // the fade takes 1/240 of the level a sample, starting it over jumps by a third of it
+            expectLessThan(max_step, peak * 0.02f);
+        }
+    }
+
+private:
+    //==============================================================================
+    static constexpr double SAMPLE_RATE  = 48000.0;
+    static constexpr float  SUSTAIN      = 0.5f;
+    static constexpr int    BLOCK_SIZE   = 32;
+    static constexpr int    FIRST_STEAL  = 44; // near the sine's peak
+    static constexpr int    SECOND_STEAL = 47;
+    static constexpr int    NUM_BLOCKS   = 64;
+
+    static ADSRProcessor makeADSR ()
+    {
+        ADSRProcessor adsr;
+        adsr.prepare({ SAMPLE_RATE, 512, 1 });
+        adsr.setParameter(ADSRStages::ATTACK,  1.0f);
+        adsr.setParameter(ADSRStages::DECAY,   1.0f);
+        adsr.setParameter(ADSRStages::SUSTAIN, SUSTAIN);
+        adsr.setParameter(ADSRStages::RELEASE, 1.0f);
+        return adsr;
+    }
+    // The level after num_samples more.
+    static float step (ADSRProcessor& adsr, int num_samples)
+    {
+        auto level = adsr.getLevel();
+        for (int sample = 0; sample < num_samples; ++sample)
+        {
+            level = adsr.getNextSample();
+        }
+        return level;
+    }
+};
+
+static EnvelopeTests envelope_tests;
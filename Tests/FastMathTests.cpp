@@ -0,0 +1,124 @@
+/*
+  ==============================================================================
+
+    FastMathTests.cpp
+    FastMath against the standard library, over the inputs the synth feeds it.
+
+  ==============================================================================
+*/
+
+#include "FastMath.h"
+
+//==============================================================================
+class FastMathTests : public juce::UnitTest
+{
+public:
+    FastMathTests (): juce::UnitTest("FastMath", "GGranula") {}
+    
+    void runTest () override
+    {
+        // oscillator phases, wrapped after FM, and the pan law's quarter turn
+        beginTest("sin2pi and cos2pi over [-1, 2] cycles");
+        {
+            double max_error = 0.0;
+            forEachStep(-1.0f, 2.0f, [&] (float cycles)
+            {
+                const auto radians = juce::MathConstants<double>::twoPi * cycles;
+                max_error = juce::jmax(max_error, std::abs(FastMath::sin2pi(cycles) - std::sin(radians)),
+                                                  std::abs(FastMath::cos2pi(cycles) - std::cos(radians)));
+            });
+            expectLessOrEqual(max_error, 2.5e-7, "absolute error");
+            for (int half = -2; half <= 4; ++half) // silent lanes and voices sit at phase 0
+            {
+                const auto cycles = static_cast<float>(half) * 0.5f;
+                expectEquals(FastMath::sin2pi(cycles), 0.0f);
+                expectEquals(FastMath::cos2pi(cycles + 0.25f), 0.0f);
+            }
+        }
+        
+        // pitch ratios, a third of an octave at most, and the filter's key
+        // tracking and velocity, from 9 2/3 octaves down to 5 2/3 up
+        beginTest("exp2 over [-10, 6] octaves");
+        {
+            double max_error = 0.0;
+            forEachStep(-10.0f, 6.0f, [&] (float x)
+            {
+                max_error = juce::jmax(max_error, std::abs(FastMath::exp2(x) / std::exp2(static_cast<double>(x)) - 1.0));
+            });
+            expectLessOrEqual(max_error, 1.0e-7, "relative error");
+            for (int octave = -12; octave <= 12; ++octave)
+            {
+                expectEquals(FastMath::exp2(static_cast<float>(octave)), std::exp2(static_cast<float>(octave)));
+            }
+        }
+        
+        // past the limit where it's 1 in float, and the series around 0 on its own
+        beginTest("tanh over [-10, 10]");
+        {
+            double max_error = 0.0;
+            forEachStep(-10.0f, 10.0f, [&] (float x)
+            {
+                max_error = juce::jmax(max_error, std::abs(FastMath::tanh(x) - std::tanh(static_cast<double>(x))));
+            });
+            expectLessOrEqual(max_error, 2.5e-7, "absolute error");
+            double max_relative_error = 0.0;
+            forEachStep(-0.0625f, 0.0625f, [&] (float x)
+            {
+                if (x == 0.0f || std::abs(x) == 0.0625f) return; // 1/16 itself takes the exp2 path
+                const auto expected = std::tanh(static_cast<double>(x));
+                max_relative_error = juce::jmax(max_relative_error, std::abs(FastMath::tanh(x) / expected - 1.0));
+            });
+            expectLessOrEqual(max_relative_error, 1.0e-7, "relative error below 1/16");
+            expectEquals(FastMath::tanh(0.0f), 0.0f);
+            expectEquals(FastMath::tanh(10.0f), 1.0f);
+            expectEquals(FastMath::tanh(-100.0f), -1.0f);
+        }
+        
+        // the carrier phase plus up to 10 / 2 pi cycles of modulation
+        beginTest("wrap over [-4, 4] cycles");
+        {
+            double max_error = 0.0;
+            bool in_range = true;
+            forEachStep(-4.0f, 4.0f, [&] (float cycles)
+            {
+                const auto wrapped = FastMath::wrap(cycles);
+                in_range  = in_range && wrapped >= 0.0f && wrapped <= 1.0f;
+                const auto error = std::abs(wrapped - (cycles - std::floor(static_cast<double>(cycles))));
+                max_error = juce::jmax(max_error, juce::jmin(error, std::abs(error - 1.0))); // 0 and 1 are the same phase
+            });
+            expect(in_range, "result outside [0, 1]");
+            expectLessOrEqual(max_error, 6.0e-8, "absolute error");
+        }
+        
+        beginTest("SIMD lanes agree with the scalar versions to the bit");
+        {
+            int num_mismatches = 0;
+            forEachStep(-4.0f, 4.0f, [&] (float x)
+            {
+                const auto lanes = FastMath::Lanes::expand(x);
+                num_mismatches += (FastMath::sin2pi(lanes).get(0) != FastMath::sin2pi(x)) ? 1 : 0;
+                num_mismatches += (FastMath::cos2pi(lanes).get(0) != FastMath::cos2pi(x)) ? 1 : 0;
+                num_mismatches += (FastMath::wrap(lanes).get(0)   != FastMath::wrap(x))   ? 1 : 0;
+                num_mismatches += (FastMath::exp2(lanes).get(0)   != FastMath::exp2(x))   ? 1 : 0;
+                num_mismatches += (FastMath::tanh(lanes).get(0)   != FastMath::tanh(x))   ? 1 : 0;
+            });
+            expectEquals(num_mismatches, 0);
+        }
+    }
+    
+private:
+    //==============================================================================
+    static constexpr int NUM_STEPS = 1 << 20;
+    
+    // Evenly spaced from start to end, both included.
+    template <typename Check>
+    static void forEachStep (float start, float end, Check&& check)
+    {
+        for (int step = 0; step <= NUM_STEPS; ++step)
+        {
+            check(start + (end - start) * static_cast<float>(step) / static_cast<float>(NUM_STEPS));
+        }
+    }
+};
+
+static FastMathTests fast_math_tests;
@@ -0,0 +1,88 @@
+/*
+  ==============================================================================
+
+    RealtimeAllocationTests.cpp
+    processBlock must not allocate, automation included.
+
+  ==============================================================================
+*/
+
+#include "PluginProcessor.h"
+
+//==============================================================================
+class RealtimeAllocationTests : public juce::UnitTest
+{
+public:
+    RealtimeAllocationTests (): juce::UnitTest("Realtime allocations", "GGranula") {}
+    
+    void runTest () override
+    {
+       #if JUCE_ENABLE_ALLOCATION_HOOKS
+        beginTest("processBlock doesn't allocate while every parameter moves");
+        
+        GGranulaAudioProcessor processor;
+        processor.setRateAndBufferSizeDetails(SAMPLE_RATE, BLOCK_SIZE);
+        processor.prepareToPlay(SAMPLE_RATE, BLOCK_SIZE);
+        
+        // built up front, adding events allocates
+        juce::AudioBuffer<float> buffer(2, BLOCK_SIZE);
+        juce::MidiBuffer no_events;
+        juce::MidiBuffer chord;
+        for (auto note : { 48, 55, 60, 64 })
+        {
+            chord.addEvent(juce::MidiMessage::noteOn(1, note, 0.8f), 17);
+        }
+        
+        auto random = getRandom();
+        for (int block = 0; block < NUM_BLOCKS; ++block)
+        {
+            for (auto* parameter : processor.getParameters())
+            {
+                parameter->setValue(random.nextFloat()); // what host automation does
+            }
+            auto& events = (block % 16 == 0) ? chord : no_events;
+            
+            int num_allocations = 0;
+            {
+                AllocationCounter counter;
+                processor.processBlock(buffer, events);
+                num_allocations = counter.getNumAllocations(); // before anything else allocates
+            }
+            expectEquals(num_allocations, 0, "block " + juce::String(block));
+        }
+        processor.releaseResources();
+       #else
+        logMessage("Skipped: allocations are only tracked with JUCE_ENABLE_ALLOCATION_HOOKS, which the Debug configuration defines");
+       #endif
+    }
+    
+private:
+    //==============================================================================
+    static constexpr double SAMPLE_RATE = 48000.0;
+    static constexpr int    BLOCK_SIZE  = 256;
+    static constexpr int    NUM_BLOCKS  = 256;
+    
+   #if JUCE_ENABLE_ALLOCATION_HOOKS
+    // Counts new and delete on this thread while it lives, the way the
+    // processor's RealtimeAllocationTripwire does.
+    class AllocationCounter : private juce::AllocationHooks::Listener
+    {
+    public:
+        AllocationCounter ()  { juce::getAllocationHooksForThread().addListener(this); }
+        ~AllocationCounter () override { juce::getAllocationHooksForThread().removeListener(this); }
+        int getNumAllocations () const noexcept
+        {
+            return _num_allocations;
+        }
+        
+    private:
+        void newOrDeleteCalled () noexcept override
+        {
+            ++_num_allocations;
+        }
+        int _num_allocations = 0;
+    };
+   #endif
+};
+
+static RealtimeAllocationTests realtime_allocation_tests;
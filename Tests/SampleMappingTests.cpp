@@ -0,0 +1,205 @@
+/*
+  ==============================================================================
+
+    SampleMappingTests.cpp
+    Grains play a memory-mapped file the way they play it decoded, and the
+    loader's prefetch reaches every frame they read.
+
+  ==============================================================================
+*/
+
+#include "PluginProcessor.h"
+
+//==============================================================================
+class SampleMappingTests : public juce::UnitTest
+{
+public:
+    SampleMappingTests (): juce::UnitTest("Sample mapping", "GGranula") {}
+
+    void runTest () override
+    {
+        const auto noise = makeNoise();
+        const std::pair<GrainInterpolation, const char*> kernels[] {
+            { GrainInterpolation::LINEAR_INTERPOLATION,  "linear" },
+            { GrainInterpolation::HERMITE_INTERPOLATION, "hermite" },
+            { GrainInterpolation::SINC_INTERPOLATION,    "sinc" }
+        };
+
+        juce::TemporaryFile file(".wav");
+        if (! writeWav(file.getFile(), noise)) return;
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::MemoryMappedAudioFormatReader> mapped(wav.createMemoryMappedReader(file.getFile()));
+        std::unique_ptr<juce::AudioFormatReader> reader(wav.createReaderFor(new juce::FileInputStream(file.getFile()), true));
+        expect(mapped != nullptr && mapped->mapEntireFile(), "can't map the file");
+        expect(reader != nullptr, "can't read the file");
+        if (mapped == nullptr || reader == nullptr) return;
+
+        // decoded the way SampleLoader does it
+        juce::AudioBuffer<float> decoded(NUM_CHANNELS, static_cast<int>(reader->lengthInSamples));
+        reader->read(&decoded, 0, decoded.getNumSamples(), 0, true, true);
+        const Sample::Ptr in_memory = new Sample(std::move(decoded), reader->sampleRate, "decoded");
+        const Sample::Ptr from_map  = new Sample(std::move(mapped), "mapped");
+
+        for (const auto& kernel : kernels)
+        {
+            beginTest(juce::String("Mapped and decoded files render the same cloud, ") + kernel.second);
+
+            // no jitter or spread, the only randomness there is; the position sweeps the whole file instead
+            Settings settings;
+            settings.interpolation = kernel.first;
+            settings.pitch         = 19.0f; // an octave and more, several runs of mapped frames a block
+            settings.sweep         = true;
+            const auto mapped_output  = render(*from_map, settings);
+            const auto decoded_output = render(*in_memory, settings);
+
+            float max_difference = 0.0f;
+            for (int channel = 0; channel < NUM_CHANNELS; ++channel)
+            {
+                for (int sample = 0; sample < NUM_SAMPLES; ++sample)
+                {
+                    max_difference = juce::jmax(max_difference, std::abs(mapped_output.getSample(channel, sample) - decoded_output.getSample(channel, sample)));
+                }
+            }
+            expect(decoded_output.getMagnitude(0, NUM_SAMPLES) > 0.01f, "nothing played");
+            expectEquals(max_difference, 0.0f, "mapped output differs");
+        }
+
+        for (const auto& kernel : kernels)
+        {
+            beginTest(juce::String("The prefetched frames hold every frame grains read, ") + kernel.second);
+
+            // the ends of the file, the clamping there, jitter over all of it, long and fast grains
+            Settings cases[] { { 0.5f, 0.5f, 0.0f }, { 0.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f },
+                               { 1.0f, 1.0f, 24.0f }, { 0.0f, 0.3f, -12.0f } };
+            for (auto& settings : cases)
+            {
+                settings.interpolation = kernel.first;
+                expectOnlyPrefetchedRead(noise, settings);
+            }
+        }
+    }
+
+private:
+    //==============================================================================
+    static constexpr double SAMPLE_RATE  = 48000.0;
+    static constexpr int    BLOCK_SIZE   = 256;
+    static constexpr int    NUM_CHANNELS = 2;
+    static constexpr int    NUM_FRAMES   = 96000; // the file's, longer than a mapped run
+    static constexpr int    NUM_SAMPLES  = 49152; // rendered, whole blocks
+    static constexpr float  POISON       = 1000.0f;
+
+    struct Settings
+    {
+        float position = 0.0f;
+        float jitter   = 0.0f;
+        float pitch    = 0.0f;
+        GrainInterpolation interpolation = GrainInterpolation::HERMITE_INTERPOLATION;
+        bool  sweep    = false; // the position from 0 to 1 over the render
+    };
+
+    // Noise at 16 bits, as the file stores it.
+    juce::AudioBuffer<float> makeNoise ()
+    {
+        juce::AudioBuffer<float> noise(NUM_CHANNELS, NUM_FRAMES);
+        auto random = getRandom();
+        for (int channel = 0; channel < NUM_CHANNELS; ++channel)
+        {
+            for (int frame = 0; frame < NUM_FRAMES; ++frame)
+            {
+                noise.setSample(channel, frame, static_cast<float>(random.nextInt(65535) - 32767) / 32768.0f);
+            }
+        }
+        return noise;
+    }
+    bool writeWav (const juce::File& file, const juce::AudioBuffer<float>& audio)
+    {
+        std::unique_ptr<juce::FileOutputStream> stream(file.createOutputStream());
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatWriter> writer(stream != nullptr ? wav.createWriterFor(stream.get(), SAMPLE_RATE, NUM_CHANNELS, 16, {}, 0) : nullptr);
+        expect(writer != nullptr, "can't write the file");
+        if (writer == nullptr) return false;
+        stream.release(); // the writer's now
+        return writer->writeFromAudioSampleBuffer(audio, 0, audio.getNumSamples());
+    }
+
+    // Everything outside the frames getUpcomingGrainFrames() names is
+    // replaced by a value far louder than the cloud, which any grain
+    // reading it would play.
+    void expectOnlyPrefetchedRead (const juce::AudioBuffer<float>& noise, const Settings& settings)
+    {
+        const auto name = "position " + juce::String(settings.position, 1) + ", jitter " + juce::String(settings.jitter, 1)
+                        + ", pitch " + juce::String(settings.pitch, 0);
+        const auto frames = getUpcomingFrames(noise, settings);
+        expect(! frames.isEmpty(), "nothing to prefetch, " + name);
+
+        juce::AudioBuffer<float> poisoned(noise.getNumChannels(), noise.getNumSamples());
+        for (int channel = 0; channel < noise.getNumChannels(); ++channel)
+        {
+            for (int frame = 0; frame < noise.getNumSamples(); ++frame)
+            {
+                poisoned.setSample(channel, frame, frames.contains(frame) ? noise.getSample(channel, frame) : POISON);
+            }
+        }
+        const Sample::Ptr sample = new Sample(std::move(poisoned), SAMPLE_RATE, "poisoned");
+        const auto output = render(*sample, settings);
+        const auto magnitude = output.getMagnitude(0, NUM_SAMPLES);
+        expect(magnitude > 0.01f, "nothing played, " + name);
+        expectLessThan(magnitude, 10.0f, "read outside the prefetched frames, " + name);
+    }
+    juce::Range<juce::int64> getUpcomingFrames (const juce::AudioBuffer<float>& noise, const Settings& settings)
+    {
+        juce::AudioBuffer<float> copy(noise);
+        const Sample::Ptr sample = new Sample(std::move(copy), SAMPLE_RATE, "copy");
+        Synthesizer synthesizer(std::make_shared<SynthesizerState>(makeInitialState(settings)));
+        prepare(synthesizer);
+        synthesizer.setSample(sample.get());
+        return synthesizer.getUpcomingGrainFrames();
+    }
+
+    static SynthesizerState::SynthesizerInitialState makeInitialState (const Settings& settings)
+    {
+        SynthesizerState::SynthesizerInitialState initial_state;
+        initial_state.grain_density       = 200.0f;
+        initial_state.grain_size          = 300.0f;
+        initial_state.grain_position      = settings.position;
+        initial_state.grain_jitter        = settings.jitter;
+        initial_state.grain_pitch         = settings.pitch;
+        initial_state.grain_interpolation = settings.interpolation;
+        return initial_state;
+    }
+    static void prepare (Synthesizer& synthesizer)
+    {
+        synthesizer.prepare({
+            .juce_spec = {
+                .sampleRate       = SAMPLE_RATE,
+                .maximumBlockSize = static_cast<juce::uint32>(BLOCK_SIZE),
+                .numChannels      = static_cast<juce::uint32>(NUM_CHANNELS)
+            }
+        });
+    }
+    juce::AudioBuffer<float> render (const Sample& sample, const Settings& settings)
+    {
+        auto state = std::make_shared<SynthesizerState>(makeInitialState(settings));
+        Synthesizer synthesizer(state);
+        prepare(synthesizer);
+        synthesizer.setSample(&sample);
+
+        juce::AudioBuffer<float> output(NUM_CHANNELS, NUM_SAMPLES);
+        output.clear();
+        for (int start = 0; start < NUM_SAMPLES; start += BLOCK_SIZE)
+        {
+            if (settings.sweep)
+            {
+                state->setGrainParam(GrainParam::GRAIN_POSITION, static_cast<float>(start) / NUM_SAMPLES);
+            }
+            juce::dsp::AudioBlock<BufferData> block(output.getArrayOfWritePointers(), NUM_CHANNELS,
+                                                    static_cast<size_t>(start), static_cast<size_t>(BLOCK_SIZE));
+            juce::dsp::ProcessContextReplacing<BufferData> context(block);
+            juce::MidiBuffer events;
+            synthesizer.renderNextBlock({ .juce_context = context }, events);
+        }
+        return output;
+    }
+};
+
+static SampleMappingTests sample_mapping_tests;
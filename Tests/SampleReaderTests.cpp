@@ -0,0 +1,128 @@
+/*
+  ==============================================================================
+
+    SampleReaderTests.cpp
+    Every interpolation kernel against signals whose values between frames
+    are known.
+
+  ==============================================================================
+*/
+
+#include "SampleReader.h"
+
+//==============================================================================
+class SampleReaderTests : public juce::UnitTest
+{
+public:
+    SampleReaderTests (): juce::UnitTest("SampleReader", "GGranula") {}
+
+    void runTest () override
+    {
+        // linear's are its worst case, (2 pi f)^2 / 8; the others' about twice
+        // what they were measured at, and below the cheaper kernel's
+        testKernel<SampleReader::Linear>("Linear",   { 1.3e-3, 8.0e-2, 4.5e-1 });
+        testKernel<SampleReader::Hermite>("Hermite", { 3.0e-5, 2.0e-2, 3.0e-1 });
+        testKernel<SampleReader::Sinc>("Sinc",       { 1.0e-4, 1.0e-4, 5.0e-4 });
+    }
+
+private:
+    //==============================================================================
+    static constexpr int NUM_FRAMES    = 4096;
+    static constexpr int NUM_POSITIONS = 20000;
+
+    // Largest absolute errors allowed reading a sine of LOW, MID and HIGH cycles per frame.
+    struct SineBounds
+    {
+        double low, mid, high;
+    };
+    static constexpr double LOW  = 1.0 / 64.0; // 750 Hz in a 48 kHz recording
+    static constexpr double MID  = 0.125;      // 6 kHz
+    static constexpr double HIGH = 0.3;        // 14.4 kHz, most of the passband
+
+    template <typename Reader>
+    void testKernel (const juce::String& name, SineBounds bounds)
+    {
+        beginTest(name + ": sines between frames");
+        {
+            expectLessOrEqual(getSineError<Reader>(LOW),  bounds.low,  "low sine");
+            expectLessOrEqual(getSineError<Reader>(MID),  bounds.mid,  "mid sine");
+            expectLessOrEqual(getSineError<Reader>(HIGH), bounds.high, "high sine");
+        }
+
+        beginTest(name + ": impulse and constant");
+        {
+            std::vector<float> impulse(NUM_FRAMES, 0.0f);
+            const auto centre = NUM_FRAMES / 2;
+            impulse[static_cast<size_t>(centre)] = 1.0f;
+            std::vector<float> constant(NUM_FRAMES, 0.25f);
+
+            auto random = getRandom();
+            double max_asymmetry = 0.0;
+            double max_outside   = 0.0;
+            double max_dc_error  = 0.0;
+            for (int step = 0; step < NUM_POSITIONS; ++step)
+            {
+                // read the impulse from as far either side as the kernel reaches, and past that
+                const auto offset = (2.0 * random.nextDouble() - 1.0) * (SampleReader::MARGIN + 4);
+                const auto before = read<Reader>(impulse, centre - offset);
+                const auto after  = read<Reader>(impulse, centre + offset);
+                max_asymmetry = juce::jmax(max_asymmetry, std::abs(before - after));
+                if (std::abs(offset) >= SampleReader::MARGIN)
+                {
+                    max_outside = juce::jmax(max_outside, std::abs(after));
+                }
+                max_dc_error = juce::jmax(max_dc_error, std::abs(read<Reader>(constant, centre + offset) - 0.25));
+            }
+            // symmetric kernels, so grains read as well forwards as backwards
+            expectLessOrEqual(max_asymmetry, 1.0e-6, "asymmetric impulse response");
+            expectEquals(max_outside, 0.0, "read further than MARGIN frames");
+            expectLessOrEqual(max_dc_error, 1.0e-6, "DC gain off unity");
+            if (Reader::NUM_POINTS <= 4) // only the sinc filters the frames themselves
+            {
+                expectEquals(read<Reader>(impulse, centre), 1.0, "frame not read back");
+                expectEquals(read<Reader>(impulse, centre + 1), 0.0, "neighbour leaks into a frame");
+            }
+        }
+    }
+
+    // The largest error reading a unit sine at random positions.
+    template <typename Reader>
+    double getSineError (double cycles_per_frame)
+    {
+        std::vector<float> sine(NUM_FRAMES);
+        for (size_t frame = 0; frame < sine.size(); ++frame)
+        {
+            sine[frame] = static_cast<float>(std::sin(juce::MathConstants<double>::twoPi * cycles_per_frame * static_cast<double>(frame)));
+        }
+        auto random = getRandom();
+        double max_error = 0.0;
+        for (int step = 0; step < NUM_POSITIONS; ++step)
+        {
+            const auto position = SampleReader::MARGIN + random.nextDouble() * (NUM_FRAMES - 1 - 2 * SampleReader::MARGIN);
+            const auto expected = std::sin(juce::MathConstants<double>::twoPi * cycles_per_frame * position);
+            max_error = juce::jmax(max_error, std::abs(read<Reader>(sine, position) - expected));
+        }
+        return max_error;
+    }
+
+    // Reads position through the kernel the way GrainEngine does, in one
+    // lane while the others read elsewhere.
+    template <typename Reader>
+    double read (const std::vector<float>& source, double position)
+    {
+        SampleReader::Points<Reader::NUM_POINTS> points;
+        const auto reading = static_cast<size_t>(_random.nextInt(static_cast<int>(SampleReader::NUM_LANES)));
+        for (size_t lane = 0; lane < SampleReader::NUM_LANES; ++lane)
+        {
+            const auto lane_position = (lane == reading) ? position
+                                                         : SampleReader::MARGIN + _random.nextDouble() * (static_cast<double>(source.size()) - 1 - 2 * SampleReader::MARGIN);
+            const auto index = static_cast<int>(lane_position);
+            points.gather(lane, source.data(), index, Reader::FIRST, static_cast<float>(lane_position - index));
+        }
+        return Reader::interpolate(points).get(reading);
+    }
+
+    juce::Random _random { 1 };
+};
+
+static SampleReaderTests sample_reader_tests;
@@ -0,0 +1,90 @@
+/*
+  ==============================================================================
+
+    SampleSwapTests.cpp
+    Loading another sample while grains play doesn't click.
+
+  ==============================================================================
+*/
+
+#include "PluginProcessor.h"
+
+//==============================================================================
+class SampleSwapTests : public juce::UnitTest
+{
+public:
+    SampleSwapTests (): juce::UnitTest("Sample swap", "GGranula") {}
+
+    void runTest () override
+    {
+        beginTest("Grains of the replaced sample fade out, the new sample's follow");
+
+        SynthesizerState::SynthesizerInitialState initial_state;
+        initial_state.grain_density  = 200.0f;
+        initial_state.grain_size     = 100.0f;
+        initial_state.grain_position = 0.5f;
+        Synthesizer synthesizer(std::make_shared<SynthesizerState>(initial_state));
+        synthesizer.prepare({
+            .juce_spec = {
+                .sampleRate       = SAMPLE_RATE,
+                .maximumBlockSize = static_cast<juce::uint32>(BLOCK_SIZE),
+                .numChannels      = 2
+            }
+        });
+
+        // constant samples of opposite sign: whatever the grains, the output follows the windows
+        const Sample::Ptr old_sample = makeConstantSample(0.5f);
+        const Sample::Ptr new_sample = makeConstantSample(-0.5f);
+        juce::AudioBuffer<float> output(2, NUM_SAMPLES);
+        output.clear();
+        synthesizer.setSample(old_sample.get());
+
+        int released_at = -1;
+        for (int start = 0; start < NUM_SAMPLES; start += BLOCK_SIZE)
+        {
+            if (start == SWAP_AT)
+            {
+                synthesizer.setSample(new_sample.get());
+                expect(synthesizer.isReadingReplacedSample(), "the playing grains were cut");
+            }
+            juce::dsp::AudioBlock<BufferData> block(output.getArrayOfWritePointers(), 2, static_cast<size_t>(start), static_cast<size_t>(BLOCK_SIZE));
+            juce::dsp::ProcessContextReplacing<BufferData> context(block);
+            juce::MidiBuffer events;
+            synthesizer.renderNextBlock({ .juce_context = context }, events);
+            if (start >= SWAP_AT && released_at < 0 && ! synthesizer.isReadingReplacedSample())
+            {
+                released_at = start + BLOCK_SIZE;
+            }
+        }
+
+        const auto* left = output.getReadPointer(0);
+        float max_step = 0.0f;
+        for (int sample = 1; sample < NUM_SAMPLES; ++sample)
+        {
+            max_step = juce::jmax(max_step, std::abs(left[sample] - left[sample - 1]));
+        }
+        expect(left[SWAP_AT - 1] > 0.05f, "nothing played from the old sample");
+        expect(output.getMagnitude(0, NUM_SAMPLES - 4096, 4096) > 0.05f && left[NUM_SAMPLES - 1] < 0.0f, "nothing played from the new sample");
+        expect(released_at > 0 && released_at - SWAP_AT <= juce::roundToInt(GrainEngine::SWAP_FADE * SAMPLE_RATE) + BLOCK_SIZE,
+               "the old sample was held longer than the fade");
+        // a cut drops the whole level at once, the fade takes it down over SWAP_FADE
+        expectLessThan(max_step, left[SWAP_AT - 1] * MAX_STEP_SHARE);
+    }
+
+private:
+    //==============================================================================
+    static constexpr double SAMPLE_RATE    = 48000.0;
+    static constexpr int    BLOCK_SIZE     = 128;
+    static constexpr int    NUM_SAMPLES    = 48000;
+    static constexpr int    SWAP_AT        = 24064; // grains of every age are playing by then
+    static constexpr float  MAX_STEP_SHARE = 0.02f; // of the level before the swap, a 5 ms fade takes 1/240 a sample
+
+    static Sample::Ptr makeConstantSample (float value)
+    {
+        juce::AudioBuffer<float> audio(1, 48000);
+        juce::FloatVectorOperations::fill(audio.getWritePointer(0), value, audio.getNumSamples());
+        return new Sample(std::move(audio), SAMPLE_RATE, "constant");
+    }
+};
+
+static SampleSwapTests sample_swap_tests;
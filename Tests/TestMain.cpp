@@ -0,0 +1,27 @@
+/*
+  ==============================================================================
+
+    TestMain.cpp
+    Runs the unit tests; fails when any of them does.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+
+//==============================================================================
+int main ()
+{
+    juce::ScopedJuceInitialiser_GUI juce_initialiser; // the processor expects a message manager
+    
+    juce::UnitTestRunner runner;
+    runner.setAssertOnFailure(false);
+    runner.runTestsInCategory("GGranula");
+    
+    int num_failures = 0;
+    for (int index = 0; index < runner.getNumResults(); ++index)
+    {
+        num_failures += runner.getResult(index)->failures;
+    }
+    return (num_failures > 0) ? 1 : 0;
+}
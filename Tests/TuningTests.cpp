@@ -0,0 +1,104 @@
+/*
+  ==============================================================================
+
+    TuningTests.cpp
+    Bend, fine tune and unison detune reach a note the same way whether they
+    changed before it started or while it sounds.
+
+  ==============================================================================
+*/
+
+#include "PluginProcessor.h"
+
+//==============================================================================
+class TuningTests : public juce::UnitTest
+{
+public:
+    TuningTests (): juce::UnitTest("Tuning", "GGranula") {}
+
+    void runTest () override
+    {
+        for (auto render_mode : { VoiceRenderMode::PER_VOICE, VoiceRenderMode::SIMD_BANK })
+        {
+            beginTest(juce::String("A note started after a retune plays retuned, ")
+                      + (render_mode == VoiceRenderMode::PER_VOICE ? "per voice" : "SIMD bank"));
+
+            const auto idle     = render(render_mode, false);
+            const auto sounding = render(render_mode, true);
+            const auto untuned  = render(render_mode, false, false);
+
+            expect(sounding.getMagnitude(0, 0, NUM_SAMPLES) > 0.01f, "nothing played");
+            expectEquals(getMaxDifference(idle, sounding), 0.0f, "the idle voices missed the retune");
+            expect(getMaxDifference(idle, untuned) > 0.01f, "the retune changed nothing");
+        }
+    }
+
+private:
+    //==============================================================================
+    static constexpr double SAMPLE_RATE = 48000.0;
+    static constexpr int    BLOCK_SIZE  = 128;
+    static constexpr int    NUM_SAMPLES = 8192;
+
+    // Retunes the synthesizer before its first note, or just after it.
+    static juce::AudioBuffer<float> render (VoiceRenderMode render_mode, bool retune_after_note, bool retune = true)
+    {
+        SynthesizerState::SynthesizerInitialState initial_state;
+        initial_state.num_of_voices       = 4;
+        initial_state.osc_1_unison_voices = 3;
+        initial_state.osc_2_unison_voices = 2;
+        initial_state.filter_cutoff       = 20000.0f;
+        initial_state.voice_render_mode   = render_mode;
+        auto state = std::make_shared<SynthesizerState>(initial_state);
+        Synthesizer synthesizer(state);
+        synthesizer.prepare({
+            .juce_spec = {
+                .sampleRate       = SAMPLE_RATE,
+                .maximumBlockSize = static_cast<juce::uint32>(BLOCK_SIZE),
+                .numChannels      = 2
+            }
+        });
+
+        const auto note = juce::MidiMessage::noteOn(1, 60, 0.8f);
+        if (retune_after_note)
+        {
+            synthesizer.noteOn(note);
+        }
+        if (retune)
+        {
+            synthesizer.handleMidiEvent(juce::MidiMessage::pitchWheel(1, 11000));
+            state->setFineTune(SynthOSC::FIRST_OSC, 37.0f);
+            state->setFineTune(SynthOSC::SECOND_OSC, -12.0f);
+            state->setUnisonDetune(SynthOSC::FIRST_OSC, 25.0f);
+            state->setUnisonDetune(SynthOSC::SECOND_OSC, 15.0f);
+        }
+        if (! retune_after_note)
+        {
+            synthesizer.noteOn(note);
+        }
+
+        juce::AudioBuffer<float> output(2, NUM_SAMPLES);
+        output.clear();
+        for (int start = 0; start < NUM_SAMPLES; start += BLOCK_SIZE)
+        {
+            juce::dsp::AudioBlock<BufferData> block(output.getArrayOfWritePointers(), 2, static_cast<size_t>(start), static_cast<size_t>(BLOCK_SIZE));
+            juce::dsp::ProcessContextReplacing<BufferData> context(block);
+            juce::MidiBuffer events;
+            synthesizer.renderNextBlock({ .juce_context = context }, events);
+        }
+        return output;
+    }
+    static float getMaxDifference (const juce::AudioBuffer<float>& first, const juce::AudioBuffer<float>& second)
+    {
+        float max_difference = 0.0f;
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            for (int sample = 0; sample < NUM_SAMPLES; ++sample)
+            {
+                max_difference = juce::jmax(max_difference, std::abs(first.getSample(channel, sample) - second.getSample(channel, sample)));
+            }
+        }
+        return max_difference;
+    }
+};
+
+static TuningTests tuning_tests;
@@ -0,0 +1,138 @@
+/*
+  ==============================================================================
+
+    UnisonTests.cpp
+    Each oscillator stacks its own copies, and both render paths play the
+    stacks alike.
+
+  ==============================================================================
+*/
+
+#include "PluginProcessor.h"
+
+//==============================================================================
+class UnisonTests : public juce::UnitTest
+{
+public:
+    UnisonTests (): juce::UnitTest("Unison", "GGranula") {}
+
+    void runTest () override
+    {
+        beginTest("OSC #2 plays the same whatever OSC #1 stacks");
+        {
+            // no FM, nothing but sums after the oscillators: OSC #2's share is what
+            // changes with its transpose, and a supersaw on OSC #1 mustn't touch it
+            Settings supersaw;
+            supersaw.osc_1_unison = 7;
+            Settings single;
+            single.osc_1_unison = 1;
+            auto sub = supersaw;
+            sub.osc_2_transpose = VoiceTranspose::MINUS_ONE_OCTAVE;
+            auto single_sub = single;
+            single_sub.osc_2_transpose = VoiceTranspose::MINUS_ONE_OCTAVE;
+
+            const auto with_stack    = getDifference(render(supersaw), render(sub));
+            const auto without_stack = getDifference(render(single), render(single_sub));
+            expect(with_stack.getMagnitude(0, 0, NUM_SAMPLES) > 0.01f, "OSC #2 is silent");
+            expectLessThan(getMaxDifference(with_stack, without_stack), MAX_DIFFERENCE);
+        }
+
+        const Settings stacks[] { { 7, 1, false, false }, { 1, 5, false, true }, { 3, 6, true, false }, { 9, 2, true, true } };
+        for (const auto& stack : stacks)
+        {
+            beginTest("Per voice and SIMD bank render " + juce::String(stack.osc_1_unison) + " and " + juce::String(stack.osc_2_unison) + " copies alike"
+                      + (stack.modulated ? ", FM" : "") + (stack.filtered ? ", filtered" : ""));
+
+            auto per_voice = stack;
+            per_voice.render_mode = VoiceRenderMode::PER_VOICE;
+            auto simd_bank = stack;
+            simd_bank.render_mode = VoiceRenderMode::SIMD_BANK;
+            const auto expected = render(per_voice);
+            expect(expected.getMagnitude(0, 0, NUM_SAMPLES) > 0.01f, "nothing played");
+            expectLessThan(getMaxDifference(expected, render(simd_bank)), MAX_DIFFERENCE);
+        }
+    }
+
+private:
+    //==============================================================================
+    static constexpr double SAMPLE_RATE    = 48000.0;
+    static constexpr int    BLOCK_SIZE     = 128;
+    static constexpr int    NUM_SAMPLES    = 16384;
+    static constexpr float  MAX_DIFFERENCE = 1.0e-5f; // rounding, a copy too many or too few is far louder
+
+    struct Settings
+    {
+        int  osc_1_unison = 1;
+        int  osc_2_unison = 1;
+        bool modulated    = false;
+        bool filtered     = false;
+        VoiceTranspose  osc_2_transpose = VoiceTranspose::NO_TRANSPOSE;
+        VoiceRenderMode render_mode     = VoiceRenderMode::SIMD_BANK;
+    };
+
+    // A chord held over the whole render, both stacks detuned and spread apart.
+    static juce::AudioBuffer<float> render (const Settings& settings)
+    {
+        SynthesizerState::SynthesizerInitialState initial_state;
+        initial_state.osc_1_wave_type     = VoiceWaveType::SAW;
+        initial_state.osc_2_wave_type     = VoiceWaveType::SIN;
+        initial_state.osc_2_transpose     = settings.osc_2_transpose;
+        initial_state.osc_1_unison_voices = settings.osc_1_unison;
+        initial_state.osc_2_unison_voices = settings.osc_2_unison;
+        initial_state.osc_1_unison_detune = 30.0f;
+        initial_state.osc_2_unison_detune = 12.0f;
+        initial_state.osc_1_unison_spread = 1.0f;
+        initial_state.osc_2_unison_spread = 0.3f;
+        initial_state.fm_index            = settings.modulated ? 2.0f : 0.0f;
+        initial_state.filter_mode         = settings.filtered ? FilterMode::PER_VOICE_FILTER : FilterMode::GLOBAL_FILTER;
+        initial_state.filter_cutoff       = settings.filtered ? 2000.0f : 20000.0f;
+        initial_state.amp_attack          = 0.01f;
+        initial_state.voice_render_mode   = settings.render_mode;
+        Synthesizer synthesizer(std::make_shared<SynthesizerState>(initial_state));
+        synthesizer.prepare({
+            .juce_spec = {
+                .sampleRate       = SAMPLE_RATE,
+                .maximumBlockSize = static_cast<juce::uint32>(BLOCK_SIZE),
+                .numChannels      = 2
+            }
+        });
+
+        for (auto note : { 48, 55, 64 })
+        {
+            synthesizer.noteOn(juce::MidiMessage::noteOn(1, note, 0.8f));
+        }
+        juce::AudioBuffer<float> output(2, NUM_SAMPLES);
+        output.clear();
+        for (int start = 0; start < NUM_SAMPLES; start += BLOCK_SIZE)
+        {
+            juce::dsp::AudioBlock<BufferData> block(output.getArrayOfWritePointers(), 2, static_cast<size_t>(start), static_cast<size_t>(BLOCK_SIZE));
+            juce::dsp::ProcessContextReplacing<BufferData> context(block);
+            juce::MidiBuffer events;
+            synthesizer.renderNextBlock({ .juce_context = context }, events);
+        }
+        return output;
+    }
+    static juce::AudioBuffer<float> getDifference (const juce::AudioBuffer<float>& first, const juce::AudioBuffer<float>& second)
+    {
+        juce::AudioBuffer<float> difference(first);
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            difference.addFrom(channel, 0, second, channel, 0, NUM_SAMPLES, -1.0f);
+        }
+        return difference;
+    }
+    static float getMaxDifference (const juce::AudioBuffer<float>& first, const juce::AudioBuffer<float>& second)
+    {
+        float max_difference = 0.0f;
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            for (int sample = 0; sample < NUM_SAMPLES; ++sample)
+            {
+                max_difference = juce::jmax(max_difference, std::abs(first.getSample(channel, sample) - second.getSample(channel, sample)));
+            }
+        }
+        return max_difference;
+    }
+};
+
+static UnisonTests unison_tests;